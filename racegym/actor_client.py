@@ -0,0 +1,169 @@
+"""Client for ``racegym_actor``, which serves batches of native environments over TCP.
+
+A learner opens one ``ActorClient`` per actor node and creates one or more batches on it.
+Requests are pipelined: ``step_async`` returns immediately, so a learner can keep a step
+of every batch in flight while it computes actions for the batch whose results just
+arrived, hiding the network round trip. Responses come back in request order.
+
+Usage: ``python -m racegym.actor_client [HOST:PORT] [--envs N] [--batches N] [--steps N]``
+drives an actor with random actions and prints throughput and episode statistics, e.g.
+against ``racegym_actor --tracks tracks --bind 127.0.0.1`` over loopback.
+"""
+import argparse
+import collections
+import socket
+import struct
+import time
+
+import numpy as np
+
+from .episode_stats import decode_episode_stats
+
+# Layouts mirror sim/tools/actor_protocol.h
+_HEADER = struct.Struct("<IHHIII")
+_CREATE_REQUEST = struct.Struct("<Iii")
+_CREATE_RESPONSE = struct.Struct("<IIII")
+_MAGIC = 0x32434752  # "RGC2"
+_OP_CREATE, _OP_RESET, _OP_STEP, _OP_STATS, _OP_CLOSE = 1, 2, 3, 4, 5
+_FLAG_RESET_STATS = 1 << 0
+_STATUS = {1: "protocol error", 2: "out of resources"}
+
+
+class ActorClient:
+    def __init__(self, host: str = "127.0.0.1", port: int = 7717):
+        self._sock = socket.create_connection((host, port))
+        self._sock.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+        self._next_request = 1
+        self._in_flight = collections.deque()  # Request ids awaiting a response, oldest first
+        self._received = {}                    # Responses read ahead while waiting for a later one
+
+    def create_batch(self, num_envs: int, fixed_start: bool = False, max_episode_steps: int = 5000) -> "RemoteBatch":
+        request = self._send(_OP_CREATE, 0, _CREATE_REQUEST.pack(num_envs, int(fixed_start), max_episode_steps))
+        batch_id, payload = self._wait(request)
+        n, obs_size, action_size, _ = _CREATE_RESPONSE.unpack(payload)
+        return RemoteBatch(self, batch_id, n, obs_size, action_size)
+
+    def close(self) -> None:
+        self._sock.close()
+
+    def _send(self, op: int, batch_id: int, payload: bytes = b"", flags: int = 0) -> int:
+        request = self._next_request
+        self._next_request += 1
+        self._sock.sendall(_HEADER.pack(_MAGIC, op, flags, request, batch_id, len(payload)) + payload)
+        self._in_flight.append(request)
+        return request
+
+    def _read_exactly(self, size: int) -> bytearray:
+        data = bytearray(size)
+        view = memoryview(data)
+        while size:
+            n = self._sock.recv_into(view[-size:], size)
+            if n == 0:
+                raise ConnectionError("racegym_actor closed the connection")
+            size -= n
+        return data
+
+    def _wait(self, request: int) -> tuple[int, bytearray]:
+        """Return (batch id, payload) of a request, reading ahead past earlier responses."""
+        while request not in self._received:
+            magic, _, status, request_id, batch_id, size = _HEADER.unpack(self._read_exactly(_HEADER.size))
+            if magic != _MAGIC or request_id != self._in_flight.popleft():
+                raise ConnectionError("racegym_actor sent an unexpected response")
+            payload = self._read_exactly(size)
+            self._received[request_id] = (status, batch_id, payload)
+        status, batch_id, payload = self._received.pop(request)
+        if status != 0:
+            raise RuntimeError(f"racegym_actor: {_STATUS.get(status, status)}")
+        return batch_id, payload
+
+
+class RemoteBatch:
+    """A batch of environments living on an actor; finished episodes reset automatically."""
+
+    def __init__(self, client: ActorClient, batch_id: int, num_envs: int, obs_size: int, action_size: int):
+        self.client = client
+        self.batch_id = batch_id
+        self.num_envs = num_envs
+        self.obs_size = obs_size
+        self.action_size = action_size
+        self._pending = collections.deque()
+
+    def reset(self, seed: int) -> np.ndarray:
+        request = self.client._send(_OP_RESET, self.batch_id, struct.pack("<Q", seed))
+        _, payload = self.client._wait(request)
+        return np.frombuffer(payload, dtype=np.float32).reshape(self.num_envs, self.obs_size)
+
+    def step_async(self, actions: np.ndarray) -> None:
+        payload = np.ascontiguousarray(actions, dtype=np.float32).reshape(self.num_envs, self.action_size).tobytes()
+        self._pending.append(self.client._send(_OP_STEP, self.batch_id, payload))
+
+    def step_wait(self):
+        """Results of the oldest in-flight step of this batch.
+
+        Returns (obs, rewards, terminated, truncated, lap_times, terminal_obs), where obs is
+        already reset for finished episodes, lap_times is NaN where no lap was completed and
+        terminal_obs maps the index of each finished env to its last observation.
+        """
+        _, payload = self.client._wait(self._pending.popleft())
+        n, d = self.num_envs, self.obs_size
+        floats = np.frombuffer(payload, dtype=np.float32, count=n * (d + 2))
+        obs = floats[:n * d].reshape(n, d)
+        rewards = floats[n * d:n * d + n]
+        lap_times = floats[n * d + n:]
+        flags = np.frombuffer(payload, dtype=np.uint8, count=2 * n, offset=4 * n * (d + 2))
+        terminated = flags[:n].astype(bool)
+        truncated = flags[n:].astype(bool)
+        finished = np.flatnonzero(terminated | truncated)
+        terminal = np.frombuffer(payload, dtype=np.float32, offset=4 * n * (d + 2) + 2 * n).reshape(-1, d)
+        return obs, rewards, terminated, truncated, lap_times, dict(zip(finished.tolist(), terminal))
+
+    def step(self, actions: np.ndarray):
+        self.step_async(actions)
+        return self.step_wait()
+
+    def stats(self, reset: bool = False) -> dict:
+        """Episode statistics since the batch was created or its stats were last reset.
+
+        See racegym.episode_stats.decode_episode_stats for the layout.
+        """
+        request = self.client._send(_OP_STATS, self.batch_id, flags=_FLAG_RESET_STATS if reset else 0)
+        _, payload = self.client._wait(request)
+        return decode_episode_stats(payload)
+
+    def close(self) -> None:
+        self.client._wait(self.client._send(_OP_CLOSE, self.batch_id))
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Drive a racegym_actor with random actions")
+    parser.add_argument("address", nargs="?", default="127.0.0.1:7717")
+    parser.add_argument("--envs", type=int, default=64, help="Environments per batch")
+    parser.add_argument("--batches", type=int, default=2, help="Batches kept in flight")
+    parser.add_argument("--steps", type=int, default=500, help="Steps per batch")
+    args = parser.parse_args()
+
+    host, port = args.address.rsplit(":", 1)
+    client = ActorClient(host, int(port))
+    rng = np.random.default_rng(0)
+    batches = [client.create_batch(args.envs) for _ in range(args.batches)]
+    for i, batch in enumerate(batches):
+        batch.reset(seed=i)
+
+    start = time.perf_counter()
+    for batch in batches:
+        batch.step_async(rng.uniform(-1.0, 1.0, (args.envs, 2)))
+    for _ in range(args.steps - 1):
+        for batch in batches:
+            batch.step_wait()
+            batch.step_async(rng.uniform(-1.0, 1.0, (args.envs, 2)))
+    for batch in batches:
+        batch.step_wait()
+    elapsed = time.perf_counter() - start
+
+    print(f"{args.envs * args.batches * args.steps / elapsed:.0f} env steps/s over {args.batches} pipelined batches")
+    stats = batches[0].stats()
+    print(f"{stats['episodes']} episodes, mean return {stats['episode_return']['mean']:.2f}, "
+          f"mean length {stats['episode_length']['mean']:.1f}, {stats['lap_time']['count']} laps")
+    for batch in batches:
+        batch.close()
+    client.close()
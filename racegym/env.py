@@ -1,8 +1,10 @@
+import math
 import os
 import sys
 import time
 import ctypes
 from pathlib import Path
+from typing import Sequence
 
 import numpy as np
 import gymnasium as gym
@@ -22,10 +24,70 @@ def _find_sim_dll() -> Path | None:
     return None
 
 
+# sim_get_vehicle_state / sim_compute_vehicle_jacobian vector sizes
+VEHICLE_STATE_SIZE = 27
+VEHICLE_CONTROL_SIZE = 3
+
+
+class ExpertDriverParams(ctypes.Structure):
+    """Tuning of the native expert driver; see SimExpertDriverParams in sim.h."""
+    _fields_ = [
+        ("lookahead_base", ctypes.c_float),
+        ("lookahead_gain", ctypes.c_float),
+        ("max_speed", ctypes.c_float),
+        ("max_lateral_accel", ctypes.c_float),
+        ("max_brake_decel", ctypes.c_float),
+        ("speed_gain", ctypes.c_float),
+    ]
+
+
+class RolloutCost(ctypes.Structure):
+    """Weights for sim_rollout_batch; see SimRolloutCost in sim.h."""
+    _fields_ = [
+        ("progress_weight", ctypes.c_float),
+        ("off_track_penalty", ctypes.c_float),
+        ("crash_penalty", ctypes.c_float),
+        ("control_rate_weight", ctypes.c_float),
+    ]
+
+# sim_get_vehicle_states fields: (mask bit, floats per vehicle), in argument order
+VEHICLE_STATE_FIELDS = {
+    "position": (1 << 0, 3),
+    "orientation": (1 << 1, 4),
+    "linear_velocity": (1 << 2, 3),
+    "angular_velocity": (1 << 3, 3),
+    "wheel_spin": (1 << 4, 4),
+    "controls": (1 << 5, 3),
+}
+
+# Track sets are loaded once per process and shared by every env in it
+_TRACK_SETS: dict[str, int] = {}
+
+
 class RaceGymEnv(gym.Env):
     metadata = {"render_modes": ["human", None]}
 
-    def __init__(self, render_mode: str | None = None, fixed_start: bool = False, max_episode_steps: int = 5000):
+    def __init__(
+        self,
+        render_mode: str | None = None,
+        fixed_start: bool = False,
+        max_episode_steps: int = 5000,
+        track_set: str | None = None,
+        track_weights: Sequence[float] | None = None,
+        telemetry_name: str | None = None,
+        pipelined: bool = False,
+    ):
+        """
+        :param track_set: Directory of tracks to pick from on every reset. If None, always uses track1.
+        :param track_weights: Optional per-track selection weights, in file name order
+        :param telemetry_name: If set, stream per-substep telemetry to this shared memory name
+            for racegym.telemetry.TelemetryReader
+        :param pipelined: Compute observations on a sim worker thread after each physics step.
+            step() itself only overlaps them with its progress and lap bookkeeping, which is
+            usually shorter than the thread hand-off, so a lone env tends to get slower. The
+            gain comes from batch (sim_step_batch) or C callers that do other work, such as
+            inference for other envs, between stepping and reading the observations.
+        """
         assert render_mode in ("human", None), "render_mode must be 'human' or None"
         self.render_mode = render_mode
         self.fixed_start = fixed_start
@@ -38,10 +100,15 @@ class RaceGymEnv(gym.Env):
         self._sim_context: ctypes.c_void_p | None = None
         self._vehicle: ctypes.c_void_p | None = None
         self._track_length: int = 0
-        self._last_track_position: float = 0.0
+        self._last_progress: float = 0.0
         self._total_distance: float = 0.0
         self._lap_start_time: float = None
+        self._max_lap_index: int = 0
         self._n_steps: int = 0
+        self._compiled_tracks: dict[str, Path] = {}
+        self._track_set: int | None = None
+        self._track_weights = None
+        self._native_policy: int | None = None
         
         self._load_dll()
         if self._sim_context is not None:
@@ -54,6 +121,20 @@ class RaceGymEnv(gym.Env):
         if self._sim_context is None:
             raise RuntimeError("sim_init failed - returned null context")
 
+        if pipelined:
+            self._dll.sim_set_pipelined(self._sim_context, 1)
+        if telemetry_name is not None:
+            if self._dll.sim_enable_telemetry(self._sim_context, telemetry_name.encode('utf-8'), 1 << 16) != 0:
+                raise RuntimeError(f"Failed to create telemetry buffer: {telemetry_name}")
+
+        if track_set is not None:
+            self._track_set = self._load_track_set(Path(track_set))
+            if track_weights is not None:
+                n_tracks = self._dll.sim_get_track_set_size(self._track_set)
+                if len(track_weights) != n_tracks:
+                    raise ValueError(f"Expected {n_tracks} track weights, got {len(track_weights)}")
+                self._track_weights = (ctypes.c_float * n_tracks)(*track_weights)
+
     def _load_dll(self):
         if self._dll is not None:
             return
@@ -72,6 +153,18 @@ class RaceGymEnv(gym.Env):
         self._dll.sim_shutdown.restype = None
         self._dll.sim_load_track.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
         self._dll.sim_load_track.restype = None
+        self._dll.sim_compile_track.argtypes = [ctypes.c_char_p, ctypes.c_char_p]
+        self._dll.sim_compile_track.restype = ctypes.c_int
+        self._dll.sim_check_compiled_track.argtypes = [ctypes.c_char_p]
+        self._dll.sim_check_compiled_track.restype = ctypes.c_int
+        self._dll.sim_load_track_set.argtypes = [ctypes.c_char_p]
+        self._dll.sim_load_track_set.restype = ctypes.c_void_p
+        self._dll.sim_get_track_set_size.argtypes = [ctypes.c_void_p]
+        self._dll.sim_get_track_set_size.restype = ctypes.c_int
+        self._dll.sim_sample_track_set.argtypes = [ctypes.c_void_p, ctypes.c_ulonglong, ctypes.POINTER(ctypes.c_float)]
+        self._dll.sim_sample_track_set.restype = ctypes.c_int
+        self._dll.sim_select_track.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.c_int]
+        self._dll.sim_select_track.restype = ctypes.c_int
         self._dll.sim_add_vehicle.argtypes = [ctypes.c_void_p, ctypes.c_float]
         self._dll.sim_add_vehicle.restype = ctypes.c_void_p
         self._dll.sim_remove_vehicle.argtypes = [ctypes.c_void_p, ctypes.c_void_p]
@@ -80,6 +173,8 @@ class RaceGymEnv(gym.Env):
         self._dll.sim_set_vehicle_control.restype = None
         self._dll.sim_get_vehicle_track_position.argtypes = [ctypes.c_void_p, ctypes.c_void_p]
         self._dll.sim_get_vehicle_track_position.restype = ctypes.c_float
+        self._dll.sim_get_vehicle_progress.argtypes = [ctypes.c_void_p]
+        self._dll.sim_get_vehicle_progress.restype = ctypes.c_float
         self._dll.sim_get_track_length.argtypes = [ctypes.c_void_p]
         self._dll.sim_get_track_length.restype = ctypes.c_int
         self._dll.sim_is_vehicle_off_track.argtypes = [ctypes.c_void_p, ctypes.c_void_p]
@@ -88,6 +183,42 @@ class RaceGymEnv(gym.Env):
         self._dll.sim_get_observation.restype = ctypes.c_int
         self._dll.sim_get_vehicle_velocity.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_float)]
         self._dll.sim_get_vehicle_velocity.restype = None
+        self._dll.sim_get_vehicle_count.argtypes = [ctypes.c_void_p]
+        self._dll.sim_get_vehicle_count.restype = ctypes.c_int
+        self._dll.sim_get_vehicle_states.argtypes = [ctypes.c_void_p, ctypes.c_int] + [ctypes.POINTER(ctypes.c_float)] * 6 + [ctypes.c_int]
+        self._dll.sim_get_vehicle_states.restype = ctypes.c_int
+        self._dll.sim_enable_telemetry.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_int]
+        self._dll.sim_enable_telemetry.restype = ctypes.c_int
+        self._dll.sim_set_pipelined.argtypes = [ctypes.c_void_p, ctypes.c_int]
+        self._dll.sim_set_pipelined.restype = ctypes.c_int
+        self._dll.sim_disable_telemetry.argtypes = [ctypes.c_void_p]
+        self._dll.sim_disable_telemetry.restype = None
+        self._dll.sim_get_vehicle_state.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_float)]
+        self._dll.sim_get_vehicle_state.restype = None
+        self._dll.sim_set_vehicle_state.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.POINTER(ctypes.c_float)]
+        self._dll.sim_set_vehicle_state.restype = None
+        self._dll.sim_step_batch.argtypes = [ctypes.POINTER(ctypes.c_void_p), ctypes.c_int]
+        self._dll.sim_step_batch.restype = None
+        self._dll.sim_compute_vehicle_jacobian.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_float), ctypes.POINTER(ctypes.c_float), ctypes.c_float] + [ctypes.POINTER(ctypes.c_float)] * 3
+        self._dll.sim_compute_vehicle_jacobian.restype = ctypes.c_int
+        self._dll.sim_compute_vehicle_jacobian_exact.argtypes = [ctypes.POINTER(ctypes.c_float)] * 5
+        self._dll.sim_compute_vehicle_jacobian_exact.restype = ctypes.c_int
+        self._dll.sim_rollout_batch.argtypes = [ctypes.c_void_p, ctypes.c_void_p, ctypes.POINTER(ctypes.c_float), ctypes.POINTER(ctypes.c_float), ctypes.c_int, ctypes.c_int, ctypes.POINTER(RolloutCost), ctypes.POINTER(ctypes.c_float), ctypes.POINTER(ctypes.c_float)]
+        self._dll.sim_rollout_batch.restype = ctypes.c_int
+        self._dll.sim_attach_expert_driver.argtypes = [ctypes.c_void_p, ctypes.POINTER(ExpertDriverParams)]
+        self._dll.sim_attach_expert_driver.restype = None
+        self._dll.sim_detach_expert_driver.argtypes = [ctypes.c_void_p]
+        self._dll.sim_detach_expert_driver.restype = None
+        self._dll.sim_load_policy.argtypes = [ctypes.c_char_p]
+        self._dll.sim_load_policy.restype = ctypes.c_void_p
+        self._dll.sim_free_policy.argtypes = [ctypes.c_void_p]
+        self._dll.sim_free_policy.restype = None
+        self._dll.sim_policy_forward.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_float), ctypes.c_int, ctypes.POINTER(ctypes.c_float)]
+        self._dll.sim_policy_forward.restype = ctypes.c_int
+        self._dll.sim_attach_policy.argtypes = [ctypes.c_void_p, ctypes.c_void_p]
+        self._dll.sim_attach_policy.restype = ctypes.c_int
+        self._dll.sim_detach_policy.argtypes = [ctypes.c_void_p]
+        self._dll.sim_detach_policy.restype = None
         self._dll.sim_get_track_normal.argtypes = [ctypes.c_void_p, ctypes.c_float, ctypes.POINTER(ctypes.c_float)]
         self._dll.sim_get_track_normal.restype = None
         self._dll.sim_is_vehicle_crashed.argtypes = [ctypes.c_void_p, ctypes.c_void_p]
@@ -99,12 +230,59 @@ class RaceGymEnv(gym.Env):
         path = Path(__file__).resolve().parents[1] / "tracks" / f"{name}.json"
         if not path.is_file():
             raise FileNotFoundError(f"Track file not found: {path}")
-        encoded = str(path).encode('utf-8')
+        encoded = str(self._compile_track(path)).encode('utf-8')
         self._dll.sim_load_track(self._sim_context, encoded)
 
+    def _compile_track(self, path: Path) -> Path:
+        # Compiled tracks are memory-mapped by the sim, so all workers loading
+        # the same file share one read-only copy of the track tables
+        compiled = self._compiled_tracks.get(str(path))
+        if compiled is not None:
+            return compiled
+        compiled = path.parent / ".compiled" / f"{path.stem}.rgt"
+        # Rebuild when the source changed, or when the file is truncated or was written by
+        # a sim with a different compiled format
+        stale = (not compiled.is_file()
+                 or compiled.stat().st_mtime < path.stat().st_mtime
+                 or self._dll.sim_check_compiled_track(str(compiled).encode('utf-8')) != 0)
+        if stale:
+            compiled.parent.mkdir(exist_ok=True)
+            tmp = compiled.with_name(f"{compiled.name}.{os.getpid()}.tmp")
+            if self._dll.sim_compile_track(str(path).encode('utf-8'), str(tmp).encode('utf-8')) != 0:
+                raise RuntimeError(f"Failed to compile track: {path}")
+            try:
+                os.replace(tmp, compiled)
+            except OSError:
+                # Another worker published it first and it is already mapped
+                tmp.unlink(missing_ok=True)
+        self._compiled_tracks[str(path)] = compiled
+        return compiled
+
+    def _load_track_set(self, directory: Path) -> int:
+        key = str(directory.resolve())
+        if key in _TRACK_SETS:
+            return _TRACK_SETS[key]
+        if not directory.is_dir():
+            raise FileNotFoundError(f"Track directory not found: {directory}")
+        # Compile every JSON track so the set is memory-mapped and shared across workers
+        for path in sorted(directory.glob("*.json")):
+            self._compile_track(path)
+        track_set = self._dll.sim_load_track_set(str(directory / ".compiled").encode('utf-8'))
+        if not track_set:
+            raise RuntimeError(f"Failed to load track set: {directory}")
+        _TRACK_SETS[key] = track_set
+        return track_set
+
     def reset(self, *, seed: int | None = None, options: dict | None = None):
         super().reset(seed=seed)
-        self._load_track("track1")
+        info = {}
+        if self._track_set is not None:
+            track_seed = int(self.np_random.integers(0, 2**63))
+            track_index = self._dll.sim_sample_track_set(self._track_set, track_seed, self._track_weights)
+            self._dll.sim_select_track(self._sim_context, self._track_set, track_index)
+            info['track_index'] = track_index
+        else:
+            self._load_track("track1")
         self._track_length = self._dll.sim_get_track_length(self._sim_context)
         if self._vehicle is not None:
             self._dll.sim_remove_vehicle(self._sim_context, self._vehicle)
@@ -113,12 +291,14 @@ class RaceGymEnv(gym.Env):
         else:
             spawn_point = self.np_random.uniform(0.0,  self._dll.sim_get_track_length(self._sim_context))
         self._vehicle = self._dll.sim_add_vehicle(self._sim_context, spawn_point)
-        self._last_track_position = spawn_point
+        if self._native_policy is not None:
+            self._dll.sim_attach_policy(self._vehicle, self._native_policy)
+        self._last_progress = self._dll.sim_get_vehicle_progress(self._vehicle)
         self._total_distance = 0.0
         self._lap_start_time = None
+        self._max_lap_index = math.floor(self._last_progress / self._track_length)
         self._n_steps = 0
         obs = self._get_observation()
-        info = {}
         return obs, info
 
     def step(self, action):
@@ -126,23 +306,17 @@ class RaceGymEnv(gym.Env):
             self._dll.sim_set_vehicle_control(self._vehicle, ctypes.c_float(action[0]), ctypes.c_float(action[1]), ctypes.c_float(-action[1]))
             self._dll.sim_step(self._sim_context)
         
-        # Get current position along track
+        # Progress is unwrapped inside the sim, so no wraparound handling is needed
         current_track_position = self._dll.sim_get_vehicle_track_position(self._sim_context, self._vehicle)
-        
-        # Calculate reward with wraparound handling
-        delta = current_track_position - self._last_track_position
-        
-        # Handle wraparound at track boundaries
-        if delta > self._track_length / 2:
-            # Wrapped backwards (e.g., from 0.1 to 9.9 on a 10-segment track)
-            delta -= self._track_length
-        elif delta < -self._track_length / 2:
-            # Wrapped forwards (e.g., from 9.9 to 0.1 on a 10-segment track)
-            delta += self._track_length
-        
+        current_progress = self._dll.sim_get_vehicle_progress(self._vehicle)
+        delta = current_progress - self._last_progress
+
+        # Only the first forward crossing into each lap counts, not re-crossings after reversing
         lap_time = None
-        if current_track_position < self._track_length  / 2 and self._last_track_position > self._track_length / 2:
-            cross_time = (self._n_steps + ( (self._track_length - self._last_track_position) ) / delta) * (1.0 / 10.0)  # assuming 10 steps per second
+        lap_index = math.floor(current_progress / self._track_length)
+        if lap_index > self._max_lap_index:
+            self._max_lap_index = lap_index
+            cross_time = (self._n_steps + (lap_index * self._track_length - self._last_progress) / delta) * (1.0 / 10.0)  # assuming 10 steps per second
             if self._lap_start_time is not None:
                 lap_time = cross_time - self._lap_start_time
             self._lap_start_time = cross_time
@@ -150,8 +324,18 @@ class RaceGymEnv(gym.Env):
         
         reward = delta
         self._total_distance += delta
-        self._last_track_position = current_track_position
-        
+        self._last_progress = current_progress
+
+        # Everything above and the truncation check read only the vehicle's physics state, so
+        # in pipelined mode they run while the worker is still computing the observation and
+        # flags that the queries below wait for
+        truncated = False
+        if self._n_steps >= self.max_episode_steps:
+            truncated = True
+        info = { 'track_position': current_track_position }
+        if lap_time is not None:
+            info['lap_time'] = lap_time
+
         # Check if vehicle is off track
         terminated = False
         is_off_track = self._dll.sim_is_vehicle_off_track(self._sim_context, self._vehicle)
@@ -188,15 +372,7 @@ class RaceGymEnv(gym.Env):
             reward -= 10.0
 
         obs = self._get_observation()
-        
-        # Check for truncation due to max episode steps
-        truncated = False
-        if self._n_steps >= self.max_episode_steps:
-            truncated = True
-        
-        info = { 'track_position': current_track_position }
-        if lap_time is not None:
-            info['lap_time'] = lap_time
+
         if terminated:
             info['total_distance'] = self._total_distance
         return obs, reward, terminated, truncated, info
@@ -208,6 +384,99 @@ class RaceGymEnv(gym.Env):
         count = self._dll.sim_get_observation(self._sim_context, self._vehicle, buf, buf_len)
         return np.frombuffer(buf, dtype=np.float32, count=count)
 
+    def get_vehicle_states(self, fields: Sequence[str] = tuple(VEHICLE_STATE_FIELDS)) -> dict[str, np.ndarray]:
+        """Read the requested state fields of every vehicle in one native call.
+
+        Returns one float32 array of shape (n_vehicles, width) per field.
+        """
+        n_vehicles = self._dll.sim_get_vehicle_count(self._sim_context)
+        mask = 0
+        arrays = {}
+        pointers = []
+        for name, (bit, width) in VEHICLE_STATE_FIELDS.items():
+            if name in fields:
+                mask |= bit
+                arrays[name] = np.empty((n_vehicles, width), dtype=np.float32)
+                pointers.append(arrays[name].ctypes.data_as(ctypes.POINTER(ctypes.c_float)))
+            else:
+                pointers.append(None)
+        self._dll.sim_get_vehicle_states(self._sim_context, mask, *pointers, n_vehicles)
+        return arrays
+
+    def get_dynamics_jacobian(self, control: Sequence[float], epsilon: float = 0.0, exact: bool = False) -> tuple[np.ndarray, np.ndarray, np.ndarray]:
+        """Linearize one step of the agent's vehicle around its current state and a raw (steer, throttle, brake) control.
+
+        Uses finite differences with the given relative epsilon, or forward-mode
+        automatic differentiation when exact is set.
+        Returns (next_state, A, B) with A = d next_state / d state and B = d next_state / d control.
+        """
+        state = np.empty(VEHICLE_STATE_SIZE, dtype=np.float32)
+        self._dll.sim_get_vehicle_state(self._vehicle, state.ctypes.data_as(ctypes.POINTER(ctypes.c_float)))
+        control = np.ascontiguousarray(control, dtype=np.float32)
+        next_state = np.empty(VEHICLE_STATE_SIZE, dtype=np.float32)
+        a = np.empty((VEHICLE_STATE_SIZE, VEHICLE_STATE_SIZE), dtype=np.float32)
+        b = np.empty((VEHICLE_STATE_SIZE, VEHICLE_CONTROL_SIZE), dtype=np.float32)
+        pointer = lambda array: array.ctypes.data_as(ctypes.POINTER(ctypes.c_float))
+        if exact:
+            result = self._dll.sim_compute_vehicle_jacobian_exact(pointer(state), pointer(control),
+                                                                  pointer(next_state), pointer(a), pointer(b))
+        else:
+            result = self._dll.sim_compute_vehicle_jacobian(self._sim_context, pointer(state), pointer(control), epsilon,
+                                                            pointer(next_state), pointer(a), pointer(b))
+        if result != 0:
+            raise RuntimeError("Failed to compute dynamics Jacobian")
+        return next_state, a, b
+
+    def set_native_policy(self, path: str | os.PathLike | None):
+        """Drive the agent's vehicle with a policy exported by racegym.policy_export, or stop with None.
+
+        The network runs inside sim_step, so actions passed to step() are ignored while it is set;
+        it stays attached across resets.
+        """
+        if self._native_policy is not None:
+            self._dll.sim_detach_policy(self._vehicle)
+            self._dll.sim_free_policy(self._native_policy)
+            self._native_policy = None
+        if path is None:
+            return
+        policy = self._dll.sim_load_policy(str(path).encode('utf-8'))
+        if not policy:
+            raise RuntimeError(f"Failed to load policy: {path}")
+        if self._vehicle is not None and self._dll.sim_attach_policy(self._vehicle, policy) != 0:
+            self._dll.sim_free_policy(policy)
+            raise ValueError(f"Policy {path} does not match the observation/action sizes")
+        self._native_policy = policy
+
+    def set_expert_driver(self, enabled: bool, params: ExpertDriverParams | None = None):
+        """Let the native expert driver control the agent's vehicle until the next reset.
+
+        While enabled, actions passed to step() are ignored; the expert's controls can be
+        read back with get_vehicle_states(["controls"]) for demonstrations.
+        """
+        if enabled:
+            self._dll.sim_attach_expert_driver(self._vehicle, ctypes.byref(params) if params is not None else None)
+        else:
+            self._dll.sim_detach_expert_driver(self._vehicle)
+
+    def rollout_batch(self, controls: np.ndarray, cost: RolloutCost | None = None) -> tuple[np.ndarray, np.ndarray]:
+        """Roll out K raw (steer, throttle, brake) sequences of length H from the agent's current state.
+
+        controls has shape (K, H, 3). The environment itself is not advanced.
+        Returns (costs, final_states) with shapes (K,) and (K, VEHICLE_STATE_SIZE).
+        """
+        controls = np.ascontiguousarray(controls, dtype=np.float32)
+        n_candidates, horizon, _ = controls.shape
+        state = np.empty(VEHICLE_STATE_SIZE, dtype=np.float32)
+        costs = np.empty(n_candidates, dtype=np.float32)
+        final_states = np.empty((n_candidates, VEHICLE_STATE_SIZE), dtype=np.float32)
+        pointer = lambda array: array.ctypes.data_as(ctypes.POINTER(ctypes.c_float))
+        self._dll.sim_get_vehicle_state(self._vehicle, pointer(state))
+        cost_ref = ctypes.byref(cost) if cost is not None else None
+        if self._dll.sim_rollout_batch(self._sim_context, self._vehicle, pointer(state), pointer(controls),
+                                       n_candidates, horizon, cost_ref, pointer(costs), pointer(final_states)) != 0:
+            raise RuntimeError("Failed to roll out candidates")
+        return costs, final_states
+
     def render(self):
         # Window is handled by the sim itself in 'human' mode.
         return None
@@ -216,4 +485,7 @@ class RaceGymEnv(gym.Env):
         if self._dll is not None and self._sim_context is not None:
             self._dll.sim_shutdown(self._sim_context)
             self._sim_context = None
+        if self._dll is not None and self._native_policy is not None:
+            self._dll.sim_free_policy(self._native_policy)
+            self._native_policy = None
 
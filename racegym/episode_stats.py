@@ -0,0 +1,67 @@
+"""Decoding of the native episode statistics kept by every ``sim_vec_env`` batch.
+
+The sim aggregates episode returns, lengths, distances and lap times into running moments
+and fixed-range histograms, so thousands of environments cost one fetch instead of a
+Python dictionary per episode. ``racegym_server`` and ``racegym_actor`` clients return
+them through ``decode_episode_stats``.
+"""
+import ctypes
+
+import numpy as np
+
+# Mirrors SimStatSummary / SimEpisodeStats in sim/src/sim.h
+STATS_BUCKETS = 32
+STAT_METRICS = ("episode_return", "episode_length", "episode_distance", "lap_time")
+
+
+class StatSummary(ctypes.Structure):
+    _fields_ = [
+        ("count", ctypes.c_uint64),
+        ("sum", ctypes.c_double),
+        ("sum_squared", ctypes.c_double),
+        ("min", ctypes.c_float),
+        ("max", ctypes.c_float),
+        ("histogram_min", ctypes.c_float),
+        ("histogram_max", ctypes.c_float),
+        ("buckets", ctypes.c_uint64 * STATS_BUCKETS),
+    ]
+
+
+class EpisodeStats(ctypes.Structure):
+    _fields_ = [
+        ("steps", ctypes.c_uint64),
+        ("episodes", ctypes.c_uint64),
+        ("terminated", ctypes.c_uint64),
+        ("truncated", ctypes.c_uint64),
+        ("faulted", ctypes.c_uint64),
+    ] + [(name, StatSummary) for name in STAT_METRICS]
+
+
+def _summary_to_dict(summary: StatSummary) -> dict:
+    count = summary.count
+    mean = summary.sum / count if count else float("nan")
+    variance = max(summary.sum_squared / count - mean * mean, 0.0) if count else float("nan")
+    return {
+        "count": count,
+        "mean": mean,
+        "std": variance ** 0.5,
+        "min": summary.min if count else float("nan"),
+        "max": summary.max if count else float("nan"),
+        "histogram": np.array(summary.buckets, dtype=np.int64),
+        "bin_edges": np.linspace(summary.histogram_min, summary.histogram_max, STATS_BUCKETS + 1),
+    }
+
+
+def decode_episode_stats(data) -> dict:
+    """Turn raw SimEpisodeStats bytes into a dict with one summary dict per metric."""
+    stats = EpisodeStats.from_buffer_copy(data)
+    result = {
+        "steps": stats.steps,
+        "episodes": stats.episodes,
+        "terminated": stats.terminated,
+        "truncated": stats.truncated,
+        "faulted": stats.faulted,
+    }
+    for name in STAT_METRICS:
+        result[name] = _summary_to_dict(getattr(stats, name))
+    return result
@@ -0,0 +1,101 @@
+"""Export a trained Stable-Baselines3 policy for native inference in the sim.
+
+The actor network of an ``MlpPolicy`` (PPO/A2C mean action, or the squashed SAC mean)
+is written as a flat list of dense layers that ``sim_load_policy`` reads; see
+``MlpPolicy`` in sim/src/mlp_policy.h for the file layout. Observation statistics from
+a ``VecNormalize`` wrapper can be embedded so the native side sees the same inputs the
+network was trained on.
+
+Usage: ``python -m racegym.policy_export MODEL.zip OUT.rgmp [VECNORMALIZE.pkl]``
+"""
+import struct
+import sys
+
+_MAGIC = b"RGMP"
+_VERSION = 1
+_FLAG_NORMALIZE_INPUT = 1 << 0
+_ACTIVATIONS = {"Identity": 0, "Tanh": 1, "ReLU": 2}
+
+
+def _collect_layers(modules):
+    """Flatten Linear/activation modules into [weight, bias, activation] entries."""
+    layers = []
+    for module in modules:
+        name = type(module).__name__
+        if name == "Linear":
+            layers.append([module.weight.detach().cpu().float().numpy(),
+                           module.bias.detach().cpu().float().numpy(), 0])
+        elif name in ("Sequential", "ModuleList"):
+            layers.extend(_collect_layers(module))
+        elif name in _ACTIVATIONS:
+            if not layers or layers[-1][2] != 0:
+                raise ValueError(f"activation {name} does not follow a Linear layer")
+            layers[-1][2] = _ACTIVATIONS[name]
+        else:
+            raise ValueError(f"unsupported module in policy network: {name}")
+    return layers
+
+
+def _actor_layers(policy):
+    if hasattr(policy, "mlp_extractor"):
+        # ActorCriticPolicy (PPO, A2C): policy_net then action_net give the mean action
+        return _collect_layers([policy.mlp_extractor.policy_net, policy.action_net])
+    if hasattr(policy, "actor") and hasattr(policy.actor, "latent_pi"):
+        # SAC: latent_pi then mu, squashed by tanh
+        layers = _collect_layers([policy.actor.latent_pi, policy.actor.mu])
+        layers[-1][2] = _ACTIVATIONS["Tanh"]
+        return layers
+    raise ValueError(f"unsupported policy type: {type(policy).__name__}")
+
+
+def export_policy(model, path, vec_normalize=None):
+    """Write model's deterministic actor to path.
+
+    vec_normalize: optional VecNormalize whose observation statistics to embed.
+    """
+    layers = _actor_layers(model.policy)
+    normalize = vec_normalize is not None and vec_normalize.norm_obs
+    with open(path, "wb") as f:
+        f.write(_MAGIC + struct.pack("<III", _VERSION, len(layers), _FLAG_NORMALIZE_INPUT if normalize else 0))
+        for weight, bias, activation in layers:
+            out_size, in_size = weight.shape
+            f.write(struct.pack("<IIII", in_size, out_size, activation, 0))
+            f.write(weight.astype("<f4").tobytes())
+            f.write(bias.astype("<f4").tobytes())
+        if normalize:
+            rms = vec_normalize.obs_rms
+            f.write(rms.mean.astype("<f4").tobytes())
+            f.write((1.0 / (rms.var + vec_normalize.epsilon) ** 0.5).astype("<f4").tobytes())
+            f.write(struct.pack("<f", vec_normalize.clip_obs))
+
+
+if __name__ == "__main__":
+    if len(sys.argv) not in (3, 4):
+        print("usage: python -m racegym.policy_export MODEL.zip OUT.rgmp [VECNORMALIZE.pkl]")
+        sys.exit(1)
+
+    from stable_baselines3.common.base_class import BaseAlgorithm
+    from stable_baselines3.common.vec_env import VecNormalize
+
+    # load() lives on the concrete algorithm class; try the common ones
+    import stable_baselines3
+    model = None
+    for algorithm in ("PPO", "A2C", "SAC"):
+        try:
+            model = getattr(stable_baselines3, algorithm).load(sys.argv[1], device="cpu")
+            break
+        except Exception:
+            continue
+    if not isinstance(model, BaseAlgorithm):
+        print(f"could not load {sys.argv[1]} as PPO, A2C or SAC")
+        sys.exit(1)
+
+    stats = None
+    if len(sys.argv) == 4:
+        import pickle
+        with open(sys.argv[3], "rb") as f:
+            stats = pickle.load(f)
+        if not isinstance(stats, VecNormalize):
+            print(f"{sys.argv[3]} is not a VecNormalize pickle")
+            sys.exit(1)
+    export_policy(model, sys.argv[2], stats)
@@ -0,0 +1,152 @@
+"""Client for ``racegym_server``, which hosts the environments of several trainers in one process.
+
+Each ``RaceGymServerVecEnv`` owns a block of environments on the server. Commands go over a
+Unix domain socket; actions, observations and rewards are exchanged through a shared memory
+region, so only a few hundred bytes cross the socket per step. Step requests from different
+clients are batched together on the server, which runs the episode logic of ``RaceGymEnv``
+natively and resets finished episodes automatically.
+
+Usage::
+
+    racegym_server --socket /tmp/racegym.sock &
+    env = RaceGymServerVecEnv(64, track_set="tracks", socket_path="/tmp/racegym.sock")
+    model = PPO("MlpPolicy", VecMonitor(env))
+"""
+import ctypes
+import os
+import socket
+import struct
+
+import numpy as np
+from gymnasium import spaces
+from stable_baselines3.common.vec_env.base_vec_env import VecEnv
+
+from .episode_stats import EpisodeStats, decode_episode_stats
+from .telemetry import _attach
+
+# Layouts mirror ServerRequest / ServerResponse in sim/tools/server_protocol.h
+_REQUEST = struct.Struct("<IIIIiiQII256s")
+_RESPONSE = struct.Struct("<iIIIQ8Q64s")
+_MAGIC = 0x56534752
+_VERSION = 3
+_OP_HELLO, _OP_RESET, _OP_STEP, _OP_CLOSE, _OP_STATS = 1, 2, 3, 4, 5
+_FLAG_RESET_STATS = 1 << 0
+_STATUS = {1: "protocol error", 2: "track set could not be loaded", 3: "out of resources"}
+
+
+class RaceGymServerVecEnv(VecEnv):
+    def __init__(
+        self,
+        num_envs: int,
+        track_set: str | os.PathLike,
+        socket_path: str = "/tmp/racegym.sock",
+        fixed_start: bool = False,
+        max_episode_steps: int = 5000,
+    ):
+        """
+        :param track_set: Track directory, as seen by the server
+        :param socket_path: Unix socket the server listens on
+        """
+        observation_space = spaces.Box(low=-np.inf, high=np.inf, shape=(83,), dtype=np.float32)
+        action_space = spaces.Box(low=-1.0, high=1.0, shape=(2,), dtype=np.float32)
+        super().__init__(num_envs, observation_space, action_space)
+
+        self._sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        self._sock.connect(socket_path)
+        self._send(_OP_HELLO, num_envs=num_envs, fixed_start=int(fixed_start), max_episode_steps=max_episode_steps,
+                   track_set=os.fsencode(os.path.abspath(track_set)))
+        response = self._receive()
+        _, n, obs_size, action_size, _, *offsets = response[:12]
+        shm_name = response[12].rstrip(b"\0").decode()
+        self._shm = _attach(shm_name)
+
+        buf = self._shm.buf
+        view = lambda index, dtype, shape: np.ndarray(shape, dtype=dtype, buffer=buf, offset=offsets[index])
+        self._actions = view(0, np.float32, (n, action_size))
+        self._observations = view(1, np.float32, (n, obs_size))
+        self._rewards = view(2, np.float32, (n,))
+        self._lap_times = view(3, np.float32, (n,))
+        self._terminal_observations = view(4, np.float32, (n, obs_size))
+        self._terminated = view(5, np.uint8, (n,))
+        self._truncated = view(6, np.uint8, (n,))
+        self._stats = view(7, np.uint8, (ctypes.sizeof(EpisodeStats),))
+        self._closed = False
+
+    def _send(self, op: int, num_envs: int = 0, fixed_start: int = 0, max_episode_steps: int = 0,
+              seed: int = 0, flags: int = 0, track_set: bytes = b"") -> None:
+        self._sock.sendall(_REQUEST.pack(_MAGIC, _VERSION, op, num_envs, fixed_start, max_episode_steps,
+                                         seed, flags, 0, track_set))
+
+    def _receive(self) -> tuple:
+        data = bytearray()
+        while len(data) < _RESPONSE.size:
+            chunk = self._sock.recv(_RESPONSE.size - len(data))
+            if not chunk:
+                raise ConnectionError("racegym_server closed the connection")
+            data += chunk
+        response = _RESPONSE.unpack(data)
+        if response[0] != 0:
+            raise RuntimeError(f"racegym_server: {_STATUS.get(response[0], response[0])}")
+        return response
+
+    def reset(self) -> np.ndarray:
+        seed = self._seeds[0]
+        if seed is None:
+            seed = int(np.random.randint(0, 2**63, dtype=np.int64))
+        self._send(_OP_RESET, seed=seed)
+        self._receive()
+        self._reset_seeds()
+        return self._observations.copy()
+
+    def step_async(self, actions: np.ndarray) -> None:
+        self._actions[:] = actions
+        self._send(_OP_STEP)
+
+    def step_wait(self):
+        self._receive()
+        terminated = self._terminated.astype(bool)
+        truncated = self._truncated.astype(bool)
+        dones = terminated | truncated
+        infos = [{} for _ in range(self.num_envs)]
+        for i in np.flatnonzero(dones):
+            infos[i]["terminal_observation"] = self._terminal_observations[i].copy()
+            infos[i]["TimeLimit.truncated"] = bool(truncated[i] and not terminated[i])
+        for i in np.flatnonzero(~np.isnan(self._lap_times)):
+            infos[i]["lap_time"] = float(self._lap_times[i])
+        return self._observations.copy(), self._rewards.copy(), dones, infos
+
+    def get_episode_stats(self, reset: bool = False) -> dict:
+        """Statistics of the episodes finished since the envs were created or the stats were last reset.
+
+        Aggregated natively, so this replaces a VecMonitor at large env counts; see
+        racegym.episode_stats.decode_episode_stats for the layout.
+        """
+        self._send(_OP_STATS, flags=_FLAG_RESET_STATS if reset else 0)
+        self._receive()
+        return decode_episode_stats(self._stats.tobytes())
+
+    def close(self) -> None:
+        if self._closed:
+            return
+        self._closed = True
+        # Drop the array views before unmapping the region they point into
+        self._actions = self._observations = self._rewards = self._lap_times = None
+        self._terminal_observations = self._terminated = self._truncated = self._stats = None
+        try:
+            self._send(_OP_CLOSE)
+        except OSError:
+            pass
+        self._sock.close()
+        self._shm.close()
+
+    def get_attr(self, attr_name, indices=None):
+        return [getattr(self, attr_name)] * len(self._get_indices(indices))
+
+    def set_attr(self, attr_name, value, indices=None) -> None:
+        setattr(self, attr_name, value)
+
+    def env_method(self, method_name, *method_args, indices=None, **method_kwargs):
+        raise NotImplementedError("Environments run inside racegym_server")
+
+    def env_is_wrapped(self, wrapper_class, indices=None):
+        return [False] * len(self._get_indices(indices))
@@ -0,0 +1,116 @@
+"""Reader for the sim's shared-memory telemetry ring buffer.
+
+A training env started with ``RaceGymEnv(telemetry_name=...)`` (or any context with
+``sim_enable_telemetry``) publishes one record per vehicle per physics substep. This
+reader attaches by name from another process and never blocks the writer: records
+that were overwritten before they could be read are counted in ``dropped``.
+
+Usage: ``python -m racegym.telemetry NAME`` prints a rolling summary.
+"""
+import struct
+import sys
+import time
+from multiprocessing import shared_memory
+
+# Layouts mirror TelemetryHeader / TelemetrySlot / TelemetryRecord in sim/src/telemetry.h
+_HEADER = struct.Struct("<8sIIII")
+_WRITE_INDEX = struct.Struct("<Q")
+_WRITE_INDEX_OFFSET = 24
+_HEADER_SIZE = 64
+_SEQUENCE = struct.Struct("<Q")
+_RECORD = struct.Struct("<QIfffff4f4f4f4f4f")
+_RECORD_OFFSET = 16
+_MAGIC = b"RGTELEM\0"
+_VERSION = 1
+
+
+def _attach(name: str) -> shared_memory.SharedMemory:
+    try:
+        # The writer owns the region; don't let this process unlink it on exit
+        return shared_memory.SharedMemory(name=name, track=False)
+    except TypeError:
+        shm = shared_memory.SharedMemory(name=name)
+        if sys.platform != "win32":
+            from multiprocessing import resource_tracker
+            resource_tracker.unregister(shm._name, "shared_memory")
+        return shm
+
+
+class TelemetryReader:
+    def __init__(self, name: str, from_start: bool = False):
+        """
+        :param name: Shared memory name passed to sim_enable_telemetry
+        :param from_start: Read the records still in the ring instead of only new ones
+        """
+        self._shm = _attach(name)
+        magic, version, capacity, slot_size, header_size = _HEADER.unpack_from(self._shm.buf, 0)
+        if magic != _MAGIC or version != _VERSION:
+            self._shm.close()
+            raise RuntimeError(f"{name!r} is not a RaceGym telemetry buffer (version {_VERSION})")
+        self.capacity = capacity
+        self._slot_size = slot_size
+        self._header_size = header_size
+        self._next = 0 if from_start else self._write_index()
+        self.dropped = 0
+
+    def _write_index(self) -> int:
+        return _WRITE_INDEX.unpack_from(self._shm.buf, _WRITE_INDEX_OFFSET)[0]
+
+    def read(self) -> list[dict]:
+        """Return every complete record written since the last call, oldest first."""
+        buf = self._shm.buf
+        write_index = self._write_index()
+        if write_index - self._next > self.capacity:
+            self.dropped += write_index - self.capacity - self._next
+            self._next = write_index - self.capacity
+
+        records = []
+        while self._next < write_index:
+            offset = self._header_size + (self._next % self.capacity) * self._slot_size
+            expected = 2 * self._next + 2
+            sequence = _SEQUENCE.unpack_from(buf, offset)[0]
+            if sequence < expected:
+                break  # Claimed but not finished yet; pick it up next call
+            values = _RECORD.unpack_from(buf, offset + _RECORD_OFFSET)
+            if sequence != expected or _SEQUENCE.unpack_from(buf, offset)[0] != sequence:
+                self.dropped += 1  # Overwritten while we were reading
+                self._next += 1
+                continue
+            records.append({
+                "substep": values[0],
+                "vehicle_id": values[1],
+                "speed": values[2],
+                "yaw_rate": values[3],
+                "steer": values[4],
+                "throttle": values[5],
+                "brake": values[6],
+                "slip_ratio": values[7:11],
+                "slip_angle": values[11:15],
+                "normal_force": values[15:19],
+                "longitudinal_force": values[19:23],
+                "lateral_force": values[23:27],
+            })
+            self._next += 1
+        return records
+
+    def close(self):
+        self._shm.close()
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 2:
+        print("usage: python -m racegym.telemetry NAME")
+        sys.exit(1)
+    reader = TelemetryReader(sys.argv[1])
+    try:
+        while True:
+            time.sleep(0.5)
+            records = reader.read()
+            if records:
+                last = records[-1]
+                print(f"substep {last['substep']}: {len(records)} records, dropped {reader.dropped}, "
+                      f"speed {last['speed']:.1f} m/s, slip ratio {max(map(abs, last['slip_ratio'])):.3f}")
+    except KeyboardInterrupt:
+        pass
+    finally:
+        reader.close()
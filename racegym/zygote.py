@@ -0,0 +1,56 @@
+"""Fast start of many ``RaceGymEnv`` worker processes by forking a pre-initialised parent.
+
+``SubprocVecEnv`` normally starts every worker as a fresh interpreter, which then imports
+the package, loads the sim library and loads its track set from scratch. Here the calling
+process does all of that once (the "zygote") and the workers are ``fork``ed from it, so
+they start with the library and track tables already loaded and share those pages, and
+the interpreter's, copy-on-write. The sim's thread pool restarts its workers on both
+sides of each fork.
+
+Create the zygote vec env before the learner touches CUDA or starts threads of its own,
+and don't fork from a process with pipelined envs: only the forking thread survives.
+
+Usage::
+
+    vec_env = make_zygote_vec_env([make_env() for _ in range(256)], track_sets=["tracks"])
+
+where ``track_sets`` lists the ``track_set`` arguments the workers' envs use (None for the
+default track).
+"""
+import multiprocessing
+import os
+from typing import Callable, Sequence
+
+import gymnasium as gym
+from stable_baselines3.common.vec_env import SubprocVecEnv
+
+from .env import RaceGymEnv
+
+
+# Reset envs kept open for the life of the process: the sim only caches tracks while
+# something references them, so closing these would unload the tracks before the fork
+_PRELOADED: list[RaceGymEnv] = []
+
+
+def preload(track_sets: Sequence[str | os.PathLike | None] = ()) -> None:
+    """Load the sim library and compile and load every given track set in this process.
+
+    None stands for the default single track, which is also what an empty sequence preloads.
+    The tracks stay loaded until the process exits.
+    """
+    for track_set in list(track_sets) or [None]:
+        env = RaceGymEnv(track_set=track_set)
+        env.reset(seed=0)
+        _PRELOADED.append(env)
+
+
+def make_zygote_vec_env(env_fns: Sequence[Callable[[], gym.Env]],
+                        track_sets: Sequence[str | os.PathLike | None] = ()) -> SubprocVecEnv:
+    """A ``SubprocVecEnv`` whose workers are forked from this process after ``preload``.
+
+    Falls back to the platform's default start method where ``fork`` is unavailable (Windows).
+    """
+    if "fork" not in multiprocessing.get_all_start_methods():
+        return SubprocVecEnv(env_fns)
+    preload(track_sets)
+    return SubprocVecEnv(env_fns, start_method="fork")
@@ -0,0 +1,100 @@
+#include "arena.h"
+#include <algorithm>
+#include <cstdint>
+#include "cache_line.h"
+
+Arena::Arena()
+    : current(0), offset(0)
+{
+}
+
+Arena::~Arena()
+{
+    freeChunks();
+}
+
+void* Arena::allocate(std::size_t size, std::size_t alignment)
+{
+    for (FreeList& list : freeLists)
+    {
+        if (list.size == size && list.alignment == alignment && list.head)
+        {
+            FreeBlock* block = list.head;
+            list.head = block->next;
+            return block;
+        }
+    }
+
+    for (; current < chunks.size(); ++current, offset = 0)
+    {
+        Chunk& chunk = chunks[current];
+        std::uintptr_t base = reinterpret_cast<std::uintptr_t>(chunk.data);
+        std::uintptr_t aligned = (base + offset + alignment - 1) & ~static_cast<std::uintptr_t>(alignment - 1);
+        if (aligned + size <= base + chunk.size)
+        {
+            offset = aligned + size - base;
+            return reinterpret_cast<void*>(aligned);
+        }
+    }
+
+    // Nothing left fits: chunks start cache-line aligned, so only larger alignments need slack
+    std::size_t slack = alignment > CACHE_LINE_SIZE ? alignment : 0;
+    std::size_t next = chunks.empty() ? ARENA_FIRST_CHUNK_SIZE : std::min(chunks.back().size * 2, ARENA_MAX_CHUNK_SIZE);
+    addChunk(std::max(next, size + slack));
+    return allocate(size, alignment);
+}
+
+void Arena::deallocate(void* block, std::size_t size, std::size_t alignment)
+{
+    // Blocks too small to hold the link are simply dropped until the next reset
+    if (!block || size < sizeof(FreeBlock))
+        return;
+
+    FreeBlock* freed = static_cast<FreeBlock*>(block);
+    for (FreeList& list : freeLists)
+    {
+        if (list.size == size && list.alignment == alignment)
+        {
+            freed->next = list.head;
+            list.head = freed;
+            return;
+        }
+    }
+    freed->next = nullptr;
+    freeLists.push_back({size, alignment, freed});
+}
+
+void Arena::reset()
+{
+    if (chunks.size() > 1)
+    {
+        std::size_t total = getCapacity();
+        freeChunks();
+        addChunk(total);
+    }
+    for (FreeList& list : freeLists)
+        list.head = nullptr;
+    current = 0;
+    offset = 0;
+}
+
+std::size_t Arena::getCapacity() const
+{
+    std::size_t total = 0;
+    for (const Chunk& chunk : chunks)
+        total += chunk.size;
+    return total;
+}
+
+void Arena::addChunk(std::size_t size)
+{
+    char* data = static_cast<char*>(::operator new(size, std::align_val_t(CACHE_LINE_SIZE)));
+    chunks.push_back({data, size});
+}
+
+void Arena::freeChunks()
+{
+    for (const Chunk& chunk : chunks)
+        ::operator delete(chunk.data, std::align_val_t(CACHE_LINE_SIZE));
+    chunks.clear();
+}
@@ -0,0 +1,81 @@
+#ifndef ARENA_H
+
+#define ARENA_H
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+const std::size_t ARENA_FIRST_CHUNK_SIZE = 1024;     // Enough for a throwaway world's one vehicle
+const std::size_t ARENA_MAX_CHUNK_SIZE = 64 * 1024;  // Chunks double in size up to this
+
+// Bump allocator for objects that die together, such as everything one episode
+// creates. Memory is handed out from a list of chunks and reclaimed wholesale by
+// reset(). destroy() runs an object's destructor and keeps its slot on a free list
+// for the next object of the same size, so long-lived arenas that keep adding and
+// removing objects stay bounded. Not thread-safe.
+class Arena
+{
+public:
+    Arena();
+    ~Arena();
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(std::size_t size, std::size_t alignment);
+    // Return a block from allocate(size, alignment) for reuse
+    void deallocate(void* block, std::size_t size, std::size_t alignment);
+
+    template<typename T, typename... Args>
+    T* create(Args&&... args)
+    {
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    template<typename T>
+    void destroy(T* object)
+    {
+        if (!object)
+            return;
+        object->~T();
+        deallocate(object, sizeof(T), alignof(T));
+    }
+
+    // Forget every allocation; nothing created since the last reset may be used
+    // afterwards. Chunks are kept, and merged into one when the last cycle spilled
+    // over, so a steady workload settles into bumping through a single chunk.
+    void reset();
+
+    std::size_t getCapacity() const;
+
+private:
+    struct Chunk
+    {
+        char* data;
+        std::size_t size;
+    };
+
+    struct FreeBlock
+    {
+        FreeBlock* next;
+    };
+
+    struct FreeList
+    {
+        std::size_t size;
+        std::size_t alignment;
+        FreeBlock* head;
+    };
+
+    void addChunk(std::size_t size);
+    void freeChunks();
+
+    std::vector<Chunk> chunks;
+    std::vector<FreeList> freeLists; // One per object size seen; a handful of types
+    std::size_t current; // Chunk being bumped through
+    std::size_t offset;  // Bytes used in the current chunk
+};
+
+#endif // ARENA_H
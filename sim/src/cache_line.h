@@ -0,0 +1,12 @@
+#ifndef CACHE_LINE_H
+
+#define CACHE_LINE_H
+
+#include <cstddef>
+
+// Per-environment objects that different threads step are aligned to this, so two
+// neighbours never share a line (std::hardware_destructive_interference_size is
+// still missing from some standard libraries)
+const std::size_t CACHE_LINE_SIZE = 64;
+
+#endif // CACHE_LINE_H
@@ -0,0 +1,127 @@
+#ifndef DUAL_H
+
+#define DUAL_H
+
+#include "scalar_math.h"
+
+// Forward-mode dual number carrying N directional derivatives alongside the value.
+// Seed input j with derivative[j] = 1 and a single evaluation yields a full
+// Jacobian column block. Comparisons look only at the value, so branches in the
+// dynamics pick the same path the float instantiation would.
+template<int N>
+struct Dual
+{
+    float v;
+    float d[N];
+
+    Dual() : Dual(0.0f) {}
+    Dual(float value) : v(value)
+    {
+        for (int i = 0; i < N; ++i)
+            d[i] = 0.0f;
+    }
+
+    static Dual variable(float value, int index)
+    {
+        Dual result(value);
+        result.d[index] = 1.0f;
+        return result;
+    }
+
+    Dual operator-() const
+    {
+        Dual r(-v);
+        for (int i = 0; i < N; ++i)
+            r.d[i] = -d[i];
+        return r;
+    }
+
+    Dual &operator+=(const Dual &o)
+    {
+        v += o.v;
+        for (int i = 0; i < N; ++i)
+            d[i] += o.d[i];
+        return *this;
+    }
+
+    Dual &operator-=(const Dual &o)
+    {
+        v -= o.v;
+        for (int i = 0; i < N; ++i)
+            d[i] -= o.d[i];
+        return *this;
+    }
+};
+
+// Chain rule for a unary function with value fx and derivative dfx at a.v
+template<int N>
+Dual<N> chain(const Dual<N> &a, float fx, float dfx)
+{
+    Dual<N> r(fx);
+    for (int i = 0; i < N; ++i)
+        r.d[i] = dfx * a.d[i];
+    return r;
+}
+
+template<int N>
+Dual<N> operator+(Dual<N> a, const Dual<N> &b) { return a += b; }
+
+template<int N>
+Dual<N> operator-(Dual<N> a, const Dual<N> &b) { return a -= b; }
+
+template<int N>
+Dual<N> operator*(const Dual<N> &a, const Dual<N> &b)
+{
+    Dual<N> r(a.v * b.v);
+    for (int i = 0; i < N; ++i)
+        r.d[i] = a.d[i] * b.v + a.v * b.d[i];
+    return r;
+}
+
+template<int N>
+Dual<N> operator/(const Dual<N> &a, const Dual<N> &b)
+{
+    float inv = 1.0f / b.v;
+    Dual<N> r(a.v * inv);
+    for (int i = 0; i < N; ++i)
+        r.d[i] = (a.d[i] - r.v * b.d[i]) * inv;
+    return r;
+}
+
+// Mixed operations with plain floats avoid building throwaway zero tangents
+template<int N> Dual<N> operator+(Dual<N> a, float b) { a.v += b; return a; }
+template<int N> Dual<N> operator+(float a, Dual<N> b) { b.v += a; return b; }
+template<int N> Dual<N> operator-(Dual<N> a, float b) { a.v -= b; return a; }
+template<int N> Dual<N> operator-(float a, const Dual<N> &b) { return -b + a; }
+template<int N> Dual<N> operator*(const Dual<N> &a, float b) { return chain(a, a.v * b, b); }
+template<int N> Dual<N> operator*(float a, const Dual<N> &b) { return b * a; }
+template<int N> Dual<N> operator/(const Dual<N> &a, float b) { return a * (1.0f / b); }
+template<int N> Dual<N> operator/(float a, const Dual<N> &b) { return Dual<N>(a) / b; }
+
+template<int N> bool operator<(const Dual<N> &a, const Dual<N> &b) { return a.v < b.v; }
+template<int N> bool operator>(const Dual<N> &a, const Dual<N> &b) { return a.v > b.v; }
+template<int N> bool operator<=(const Dual<N> &a, const Dual<N> &b) { return a.v <= b.v; }
+template<int N> bool operator>=(const Dual<N> &a, const Dual<N> &b) { return a.v >= b.v; }
+template<int N> bool operator<(const Dual<N> &a, float b) { return a.v < b; }
+template<int N> bool operator>(const Dual<N> &a, float b) { return a.v > b; }
+template<int N> bool operator<=(const Dual<N> &a, float b) { return a.v <= b; }
+template<int N> bool operator>=(const Dual<N> &a, float b) { return a.v >= b; }
+
+template<int N>
+struct scalar::Ops<Dual<N>>
+{
+    static float value(const Dual<N> &a) { return a.v; }
+    static Dual<N> sin(const Dual<N> &a) { return chain(a, std::sin(a.v), std::cos(a.v)); }
+    static Dual<N> cos(const Dual<N> &a) { return chain(a, std::cos(a.v), -std::sin(a.v)); }
+    static Dual<N> atan(const Dual<N> &a) { return chain(a, std::atan(a.v), 1.0f / (1.0f + a.v * a.v)); }
+    static Dual<N> abs(const Dual<N> &a) { return a.v < 0.0f ? -a : a; }
+
+    static Dual<N> sqrt(const Dual<N> &a)
+    {
+        float root = std::sqrt(a.v);
+        // The derivative is unbounded at zero; treat it as flat like a subgradient
+        return chain(a, root, root > 0.0f ? 0.5f / root : 0.0f);
+    }
+};
+
+#endif // DUAL_H
@@ -0,0 +1,47 @@
+#include "episode_stats.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+void StatSummary::setRange(float lo, float hi) {
+    histogramMin = lo;
+    histogramMax = hi > lo ? hi : lo + 1.0f;
+    clear();
+}
+
+void StatSummary::add(float value) {
+    if (count == 0 || value < min) {
+        min = value;
+    }
+    if (count == 0 || value > max) {
+        max = value;
+    }
+    count++;
+    sum += value;
+    sumSquared += static_cast<double>(value) * value;
+
+    float position = (value - histogramMin) / (histogramMax - histogramMin) * EPISODE_STATS_BUCKETS;
+    int bucket = std::isnan(position) ? 0 : static_cast<int>(std::clamp(position, 0.0f, EPISODE_STATS_BUCKETS - 1.0f));
+    buckets[bucket]++;
+}
+
+void StatSummary::clear() {
+    count = 0;
+    sum = 0.0;
+    sumSquared = 0.0;
+    min = 0.0f;
+    max = 0.0f;
+    std::memset(buckets, 0, sizeof(buckets));
+}
+
+void EpisodeStats::clear() {
+    steps = 0;
+    episodes = 0;
+    terminated = 0;
+    truncated = 0;
+    faulted = 0;
+    episodeReturn.clear();
+    episodeLength.clear();
+    episodeDistance.clear();
+    lapTime.clear();
+}
@@ -0,0 +1,41 @@
+#ifndef EPISODE_STATS_H
+#define EPISODE_STATS_H
+
+#include <cstdint>
+
+const int EPISODE_STATS_BUCKETS = 32;
+
+// Running summary of one metric: moments, extremes and a fixed-range histogram.
+// Values outside [histogramMin, histogramMax) land in the first or last bucket.
+struct StatSummary {
+    uint64_t count;
+    double sum;
+    double sumSquared;
+    float min;
+    float max;
+    float histogramMin;
+    float histogramMax;
+    uint64_t buckets[EPISODE_STATS_BUCKETS];
+
+    void setRange(float lo, float hi);
+    void add(float value);
+    // Forget every value but keep the histogram range
+    void clear();
+};
+
+// Everything a Monitor wrapper would log, aggregated natively
+struct EpisodeStats {
+    uint64_t steps;
+    uint64_t episodes;
+    uint64_t terminated; // Off track or crashed
+    uint64_t truncated;  // Hit the step limit
+    uint64_t faulted;    // State diverged (NaN, infinity or runaway values); not counted as episodes
+    StatSummary episodeReturn;
+    StatSummary episodeLength;
+    StatSummary episodeDistance; // Track segments covered
+    StatSummary lapTime;         // Seconds, every completed lap
+
+    void clear();
+};
+
+#endif // EPISODE_STATS_H
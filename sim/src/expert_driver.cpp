@@ -0,0 +1,65 @@
+#include "expert_driver.h"
+#include <algorithm>
+#include <cmath>
+#include <glm/glm.hpp>
+#include "track.h"
+#include "vehicle.h"
+
+// Steering lock and wheelbase, matching Vehicle
+static const float MAX_STEER_ANGLE = glm::radians(30.0f);
+static const float WHEELBASE = VEHICLE_DIMENSIONS.z;
+
+ExpertDriver::ExpertDriver(const ExpertDriverParams& params)
+    : params(params)
+{
+}
+
+float ExpertDriver::getTargetSpeed(const Track& track, float t) const
+{
+    const TrackData& data = *track.getData();
+
+    // Only corners within the distance needed to brake from top speed matter
+    float horizon = params.maxSpeed * params.maxSpeed / (2.0f * params.maxBrakeDecel);
+
+    float targetSpeed = params.maxSpeed;
+    int index = data.getSampleIndex(t);
+    float distance = 0.0f;
+    for (int steps = 0; steps < data.getNumSamples() && distance < horizon; ++steps)
+    {
+        // Fastest speed the grip budget allows through this interval
+        float curvature = std::abs(data.getCurvature(static_cast<float>(index) / TRACK_SAMPLES_PER_SEGMENT));
+        float cornerSpeed = curvature > 0.0f ? std::sqrt(params.maxLateralAccel / curvature) : params.maxSpeed;
+
+        // Fastest speed now that still brakes down to it in time
+        float allowed = std::sqrt(cornerSpeed * cornerSpeed + 2.0f * params.maxBrakeDecel * distance);
+        targetSpeed = std::min(targetSpeed, allowed);
+
+        int next = (index + 1) % data.getNumSamples();
+        distance += glm::distance(data.getSample(index).position, data.getSample(next).position);
+        index = next;
+    }
+
+    return targetSpeed;
+}
+
+void ExpertDriver::drive(Vehicle& vehicle, const Track& track) const
+{
+    const PhysicsBody& body = *vehicle.body;
+    glm::vec3 forward = body.orientation * glm::vec3(0.0f, 0.0f, 1.0f);
+    glm::vec3 right = body.orientation * glm::vec3(1.0f, 0.0f, 0.0f);
+    float speed = glm::dot(body.velocity, forward);
+
+    // Pure pursuit: steer onto the arc through the centreline point one lookahead ahead
+    float lookahead = params.lookaheadBase + params.lookaheadGain * std::max(speed, 0.0f);
+    float targetT = track.getData()->advanceByDistance(vehicle.trackT, lookahead);
+    glm::vec2 target = track.getPosition(targetT);
+    glm::vec3 rel = glm::vec3(target.x, 0.0f, target.y) - body.position;
+    float lateral = glm::dot(rel, right);
+    float distanceSq = std::max(glm::dot(rel, rel), 1e-4f);
+    float steerAngle = std::atan(2.0f * WHEELBASE * lateral / distanceSq);
+    vehicle.setSteerAmount(steerAngle / MAX_STEER_ANGLE);
+
+    float speedError = getTargetSpeed(track, vehicle.trackT) - speed;
+    vehicle.setThrottle(speedError * params.speedGain);
+    vehicle.setBrake(-speedError * params.speedGain);
+}
@@ -0,0 +1,40 @@
+#ifndef EXPERT_DRIVER_H
+
+#define EXPERT_DRIVER_H
+
+class Track;
+class Vehicle;
+
+struct ExpertDriverParams
+{
+    float lookaheadBase;     // Pure-pursuit lookahead at standstill, metres
+    float lookaheadGain;     // Extra lookahead per m/s of speed, seconds
+    float maxSpeed;          // Straight-line target speed, m/s
+    float maxLateralAccel;   // Cornering grip budget, m/s^2
+    float maxBrakeDecel;     // Braking budget used to slow down for upcoming corners, m/s^2
+    float speedGain;         // Throttle/brake per m/s of speed error
+};
+
+const ExpertDriverParams DEFAULT_EXPERT_DRIVER_PARAMS = {6.0f, 0.3f, 40.0f, 8.0f, 6.0f, 0.5f};
+
+// Scripted driver: pure pursuit on the track centreline for steering, and a
+// target speed from the curvature ahead, limited so the car can brake in time.
+// Attached to a vehicle, it sets the controls before every physics substep.
+class ExpertDriver
+{
+public:
+    explicit ExpertDriver(const ExpertDriverParams& params = DEFAULT_EXPERT_DRIVER_PARAMS);
+
+    const ExpertDriverParams& getParams() const { return params; }
+
+    // Compute and apply controls from the vehicle's current state
+    void drive(Vehicle& vehicle, const Track& track) const;
+
+    // Speed the driver aims for at track parameter t
+    float getTargetSpeed(const Track& track, float t) const;
+
+private:
+    ExpertDriverParams params;
+};
+
+#endif // EXPERT_DRIVER_H
@@ -0,0 +1,183 @@
+#include "jacobian.h"
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <vector>
+#include "dual.h"
+#include "sim_context.h"
+#include "track.h"
+#include "vehicle.h"
+#include "vehicle_dynamics.h"
+
+// Controls are clamped by the vehicle, so a step past the limit would read as
+// a zero derivative; step inwards instead
+static const float CONTROL_MIN[VEHICLE_CONTROL_SIZE] = {-1.0f, 0.0f, 0.0f};
+static const float CONTROL_MAX[VEHICLE_CONTROL_SIZE] = {1.0f, 1.0f, 1.0f};
+
+// Orientation quaternion w, x, y, z in the flat state
+static const int STATE_ORIENTATION = 3;
+
+// Both paths differentiate the step taken from q / |q|: orientation inputs are read as
+// a rotation, so moving q along itself has no effect and the columns lie in the
+// tangent space of the unit sphere
+template<typename T>
+static void normaliseOrientation(T* state)
+{
+    T* q = state + STATE_ORIENTATION;
+    T norm = scalar::sqrt(q[0] * q[0] + q[1] * q[1] + q[2] * q[2] + q[3] * q[3]);
+    for (int i = 0; i < 4; ++i)
+        q[i] = q[i] / norm;
+}
+
+// One headless context per column, kept by each calling thread so repeated
+// Jacobians (e.g. every iteration of an iLQR solve) don't rebuild them
+static thread_local std::vector<std::unique_ptr<SimContext>> scratchContexts;
+
+bool computeVehicleJacobian(const SimContext& ctx, const float* state, const float* control, float epsilon,
+                            float* outNextState, float* outStateJacobian, float* outControlJacobian)
+{
+    if (!ctx.track || !state || !control)
+        return false;
+
+    if (epsilon <= 0.0f)
+        epsilon = 1e-3f;
+
+    // Column 0 is the nominal rollout; then one column per state and control dimension
+    const int numColumns = 1 + VEHICLE_STATE_SIZE + VEHICLE_CONTROL_SIZE;
+
+    std::vector<float> steps(numColumns, 0.0f);
+    std::vector<SimContext*> batch(numColumns);
+    while (static_cast<int>(scratchContexts.size()) < numColumns)
+        scratchContexts.emplace_back(new SimContext());
+
+    for (int column = 0; column < numColumns; ++column)
+    {
+        float perturbedState[VEHICLE_STATE_SIZE];
+        float perturbedControl[VEHICLE_CONTROL_SIZE];
+        std::copy(state, state + VEHICLE_STATE_SIZE, perturbedState);
+        std::copy(control, control + VEHICLE_CONTROL_SIZE, perturbedControl);
+
+        int stateIndex = column - 1;
+        int controlIndex = column - 1 - VEHICLE_STATE_SIZE;
+        if (column == 0)
+        {
+            // Nominal
+        }
+        else if (stateIndex < VEHICLE_STATE_SIZE)
+        {
+            // Scale with magnitude so large coordinates (world position) stay above float resolution
+            steps[column] = epsilon * std::max(1.0f, std::abs(state[stateIndex]));
+            perturbedState[stateIndex] += steps[column];
+        }
+        else
+        {
+            float value = std::clamp(control[controlIndex], CONTROL_MIN[controlIndex], CONTROL_MAX[controlIndex]);
+            steps[column] = (value + epsilon <= CONTROL_MAX[controlIndex]) ? epsilon : -epsilon;
+            perturbedControl[controlIndex] = value + steps[column];
+        }
+        normaliseOrientation(perturbedState);
+
+        // Scratch contexts share the immutable track data; setting it also drops the
+        // previous call's vehicle, and is just a comparison when the track is unchanged
+        SimContext* clone = scratchContexts[column].get();
+        clone->setTrack(ctx.track->getData());
+
+        Vehicle* vehicle = clone->addVehicle(0.0f);
+        vehicle->setState(perturbedState);
+        vehicle->resetTrackProgress(clone->track);
+        vehicle->setSteerAmount(perturbedControl[0]);
+        vehicle->setThrottle(perturbedControl[1]);
+        vehicle->setBrake(perturbedControl[2]);
+
+        batch[column] = clone;
+    }
+
+    stepContextBatch(batch.data(), numColumns);
+
+    std::vector<float> nextStates(numColumns * VEHICLE_STATE_SIZE);
+    for (int column = 0; column < numColumns; ++column)
+    {
+        batch[column]->vehicles[0]->getState(&nextStates[column * VEHICLE_STATE_SIZE]);
+    }
+
+    const float* nominal = &nextStates[0];
+    if (outNextState)
+        std::copy(nominal, nominal + VEHICLE_STATE_SIZE, outNextState);
+
+    for (int column = 1; column < numColumns; ++column)
+    {
+        const float* perturbed = &nextStates[column * VEHICLE_STATE_SIZE];
+        int stateIndex = column - 1;
+        int controlIndex = column - 1 - VEHICLE_STATE_SIZE;
+
+        for (int row = 0; row < VEHICLE_STATE_SIZE; ++row)
+        {
+            float derivative = (perturbed[row] - nominal[row]) / steps[column];
+            if (stateIndex < VEHICLE_STATE_SIZE)
+            {
+                if (outStateJacobian)
+                    outStateJacobian[row * VEHICLE_STATE_SIZE + stateIndex] = derivative;
+            }
+            else if (outControlJacobian)
+            {
+                outControlJacobian[row * VEHICLE_CONTROL_SIZE + controlIndex] = derivative;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool computeVehicleJacobianExact(const float* state, const float* control,
+                                 float* outNextState, float* outStateJacobian, float* outControlJacobian)
+{
+    if (!state || !control)
+        return false;
+
+    typedef Dual<VEHICLE_STATE_SIZE + VEHICLE_CONTROL_SIZE> Scalar;
+
+    Scalar seededState[VEHICLE_STATE_SIZE];
+    for (int i = 0; i < VEHICLE_STATE_SIZE; ++i)
+        seededState[i] = Scalar::variable(state[i], i);
+    normaliseOrientation(seededState);
+
+    // Controls are clamped by the vehicle; outside their range they have no effect
+    Scalar controls[VEHICLE_CONTROL_SIZE];
+    for (int i = 0; i < VEHICLE_CONTROL_SIZE; ++i)
+    {
+        float value = std::clamp(control[i], CONTROL_MIN[i], CONTROL_MAX[i]);
+        controls[i] = (value == control[i]) ? Scalar::variable(value, VEHICLE_STATE_SIZE + i) : Scalar(value);
+    }
+
+    // A throwaway vehicle supplies the body and wheel parameters
+    PhysicsWorld world;
+    Vehicle vehicle(world, glm::vec3(0.0f), glm::vec3(0.0f));
+
+    VehicleDynamicsState<Scalar> dynamics;
+    dynamics.load(seededState);
+    for (int i = 0; i < SUBSTEPS_PER_STEP; ++i)
+    {
+        stepVehicleDynamics(dynamics, vehicle, controls[0], controls[1], controls[2], SUBSTEP_DELTA);
+    }
+
+    Scalar next[VEHICLE_STATE_SIZE];
+    dynamics.store(next);
+
+    for (int row = 0; row < VEHICLE_STATE_SIZE; ++row)
+    {
+        if (outNextState)
+            outNextState[row] = next[row].v;
+        for (int column = 0; column < VEHICLE_STATE_SIZE; ++column)
+        {
+            if (outStateJacobian)
+                outStateJacobian[row * VEHICLE_STATE_SIZE + column] = next[row].d[column];
+        }
+        for (int column = 0; column < VEHICLE_CONTROL_SIZE; ++column)
+        {
+            if (outControlJacobian)
+                outControlJacobian[row * VEHICLE_CONTROL_SIZE + column] = next[row].d[VEHICLE_STATE_SIZE + column];
+        }
+    }
+
+    return true;
+}
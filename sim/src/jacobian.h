@@ -0,0 +1,27 @@
+#ifndef JACOBIAN_H
+#define JACOBIAN_H
+
+struct SimContext;
+
+// Finite-difference Jacobians of one full sim step for a single vehicle on
+// the context's track. Every perturbed column runs in its own headless scratch
+// context, reused across calls from the same thread, and all of them are
+// stepped together as one batch.
+//
+// state/outNextState hold VEHICLE_STATE_SIZE floats and control holds
+// VEHICLE_CONTROL_SIZE floats. outStateJacobian (state x state) and
+// outControlJacobian (state x control) are row-major: entry [i][j] is
+// d next_state[i] / d input[j]. Any output may be null. The step starts from
+// the orientation quaternion normalised, and the orientation columns are
+// derivatives through that normalisation: they lie in the tangent space of the
+// unit sphere, and scaling q has zero derivative.
+bool computeVehicleJacobian(const SimContext& ctx, const float* state, const float* control, float epsilon,
+                            float* outNextState, float* outStateJacobian, float* outControlJacobian);
+
+// Same outputs as computeVehicleJacobian, but exact: one step of the dynamics is
+// evaluated on dual numbers carrying a tangent per state and control dimension.
+// The dynamics do not depend on the track, so no context is needed.
+bool computeVehicleJacobianExact(const float* state, const float* control,
+                                 float* outNextState, float* outStateJacobian, float* outControlJacobian);
+
+#endif // JACOBIAN_H
@@ -0,0 +1,34 @@
+#ifndef MAPPED_FILE_H
+
+#define MAPPED_FILE_H
+
+#include <cstddef>
+
+// Read-only memory mapping of a whole file. Pages are backed by the OS file
+// cache, so every process mapping the same file shares one physical copy.
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const char* path);
+    void close();
+
+    bool isOpen() const { return data != nullptr; }
+    const void* getData() const { return data; }
+    size_t getSize() const { return size; }
+
+private:
+    const void* data;
+    size_t size;
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#endif
+};
+
+#endif // MAPPED_FILE_H
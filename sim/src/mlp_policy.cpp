@@ -0,0 +1,266 @@
+#include "mlp_policy.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define MLP_USE_SSE
+#endif
+
+namespace
+{
+    const char MLP_POLICY_MAGIC[4] = {'R', 'G', 'M', 'P'};
+    const uint32_t MLP_POLICY_VERSION = 1;
+
+    // Layer strides are padded to this many floats so every ISA path can use whole vectors
+    const int MLP_PADDING = 8;
+
+    // Rows of the batch that share each weight load in the GEMM kernel
+    const int MLP_ROW_BLOCK = 4;
+
+    struct MlpPolicyHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t numLayers;
+        uint32_t flags;
+    };
+
+    struct MlpLayerHeader
+    {
+        uint32_t inSize;
+        uint32_t outSize;
+        uint32_t activation;
+        uint32_t reserved;
+    };
+
+    // Minimal SIMD vocabulary for the kernel: widest float vector the build targets
+#if defined(__AVX__)
+    typedef __m256 Lanes;
+    const int LANE_COUNT = 8;
+    inline Lanes loadLanes(const float* p) { return _mm256_loadu_ps(p); }
+    inline void storeLanes(float* p, Lanes v) { _mm256_storeu_ps(p, v); }
+    inline Lanes broadcastLanes(float x) { return _mm256_set1_ps(x); }
+#if defined(__FMA__)
+    inline Lanes multiplyAddLanes(Lanes a, Lanes b, Lanes c) { return _mm256_fmadd_ps(a, b, c); }
+#else
+    inline Lanes multiplyAddLanes(Lanes a, Lanes b, Lanes c) { return _mm256_add_ps(_mm256_mul_ps(a, b), c); }
+#endif
+#elif defined(MLP_USE_SSE)
+    typedef __m128 Lanes;
+    const int LANE_COUNT = 4;
+    inline Lanes loadLanes(const float* p) { return _mm_loadu_ps(p); }
+    inline void storeLanes(float* p, Lanes v) { _mm_storeu_ps(p, v); }
+    inline Lanes broadcastLanes(float x) { return _mm_set1_ps(x); }
+    inline Lanes multiplyAddLanes(Lanes a, Lanes b, Lanes c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+#else
+    typedef float Lanes;
+    const int LANE_COUNT = 1;
+    inline Lanes loadLanes(const float* p) { return *p; }
+    inline void storeLanes(float* p, Lanes v) { *p = v; }
+    inline Lanes broadcastLanes(float x) { return x; }
+    inline Lanes multiplyAddLanes(Lanes a, Lanes b, Lanes c) { return a * b + c; }
+#endif
+
+    static_assert(MLP_PADDING % LANE_COUNT == 0, "layer padding must hold whole SIMD vectors");
+}
+
+std::shared_ptr<const MlpPolicy> MlpPolicy::load(const char* path)
+{
+    if (!path)
+        return nullptr;
+
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        std::cerr << "Failed to open policy file: " << path << std::endl;
+        return nullptr;
+    }
+
+    MlpPolicyHeader header;
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || std::memcmp(header.magic, MLP_POLICY_MAGIC, sizeof(header.magic)) != 0
+        || header.version != MLP_POLICY_VERSION || header.numLayers == 0)
+    {
+        std::cerr << "Invalid policy file: " << path << std::endl;
+        return nullptr;
+    }
+
+    std::shared_ptr<MlpPolicy> policy(new MlpPolicy());
+    std::vector<float> weights;
+    for (uint32_t l = 0; l < header.numLayers; ++l)
+    {
+        MlpLayerHeader layerHeader;
+        file.read(reinterpret_cast<char*>(&layerHeader), sizeof(layerHeader));
+        bool valid = file
+            && layerHeader.inSize > 0 && layerHeader.inSize <= (1u << 16)
+            && layerHeader.outSize > 0 && layerHeader.outSize <= (1u << 16)
+            && layerHeader.activation <= MLP_ACTIVATION_RELU
+            && (policy->layers.empty() || static_cast<int>(layerHeader.inSize) == policy->layers.back().outSize);
+        if (!valid)
+        {
+            std::cerr << "Invalid layer " << l << " in policy file: " << path << std::endl;
+            return nullptr;
+        }
+
+        Layer layer;
+        layer.inSize = static_cast<int>(layerHeader.inSize);
+        layer.outSize = static_cast<int>(layerHeader.outSize);
+        layer.stride = (layer.outSize + MLP_PADDING - 1) / MLP_PADDING * MLP_PADDING;
+        layer.activation = static_cast<MlpActivation>(layerHeader.activation);
+
+        // Stored as [out][in] like torch.nn.Linear; the kernel wants [in][out]
+        weights.resize(static_cast<size_t>(layer.outSize) * layer.inSize);
+        file.read(reinterpret_cast<char*>(weights.data()), weights.size() * sizeof(float));
+        layer.weights.assign(static_cast<size_t>(layer.inSize) * layer.stride, 0.0f);
+        for (int o = 0; o < layer.outSize; ++o)
+            for (int i = 0; i < layer.inSize; ++i)
+                layer.weights[static_cast<size_t>(i) * layer.stride + o] = weights[static_cast<size_t>(o) * layer.inSize + i];
+
+        layer.bias.assign(layer.stride, 0.0f);
+        file.read(reinterpret_cast<char*>(layer.bias.data()), layer.outSize * sizeof(float));
+        if (!file)
+        {
+            std::cerr << "Truncated policy file: " << path << std::endl;
+            return nullptr;
+        }
+
+        policy->maxStride = std::max(policy->maxStride, layer.stride);
+        policy->layers.push_back(std::move(layer));
+    }
+
+    if (header.flags & MLP_POLICY_NORMALIZE_INPUT)
+    {
+        int inputSize = policy->getInputSize();
+        policy->inputMean.resize(inputSize);
+        policy->inputScale.resize(inputSize);
+        file.read(reinterpret_cast<char*>(policy->inputMean.data()), inputSize * sizeof(float));
+        file.read(reinterpret_cast<char*>(policy->inputScale.data()), inputSize * sizeof(float));
+        file.read(reinterpret_cast<char*>(&policy->inputClip), sizeof(float));
+        if (!file)
+        {
+            std::cerr << "Truncated policy file: " << path << std::endl;
+            return nullptr;
+        }
+    }
+
+    return policy;
+}
+
+// out[b][o] = activation(bias[o] + sum_i in[b][i] * weights[i][o]) for the whole batch.
+// Blocks of rows share each weight vector load, and the weights of a typical policy
+// (a few hundred KB at most) stay in cache across blocks.
+void MlpPolicy::evaluateLayer(const Layer& layer, const float* in, int inStride, int batch, float* out)
+{
+    const float* weights = layer.weights.data();
+    const float* bias = layer.bias.data();
+    const int stride = layer.stride;
+
+    int row = 0;
+    for (; row + MLP_ROW_BLOCK <= batch; row += MLP_ROW_BLOCK)
+    {
+        const float* x0 = in + static_cast<size_t>(row) * inStride;
+        const float* x1 = x0 + inStride;
+        const float* x2 = x1 + inStride;
+        const float* x3 = x2 + inStride;
+        float* y0 = out + static_cast<size_t>(row) * stride;
+
+        for (int o = 0; o < stride; o += LANE_COUNT)
+        {
+            Lanes b = loadLanes(bias + o);
+            Lanes acc0 = b, acc1 = b, acc2 = b, acc3 = b;
+            for (int i = 0; i < layer.inSize; ++i)
+            {
+                Lanes w = loadLanes(weights + static_cast<size_t>(i) * stride + o);
+                acc0 = multiplyAddLanes(broadcastLanes(x0[i]), w, acc0);
+                acc1 = multiplyAddLanes(broadcastLanes(x1[i]), w, acc1);
+                acc2 = multiplyAddLanes(broadcastLanes(x2[i]), w, acc2);
+                acc3 = multiplyAddLanes(broadcastLanes(x3[i]), w, acc3);
+            }
+            storeLanes(y0 + o, acc0);
+            storeLanes(y0 + stride + o, acc1);
+            storeLanes(y0 + 2 * stride + o, acc2);
+            storeLanes(y0 + 3 * stride + o, acc3);
+        }
+    }
+
+    // Leftover rows one at a time
+    for (; row < batch; ++row)
+    {
+        const float* x = in + static_cast<size_t>(row) * inStride;
+        float* y = out + static_cast<size_t>(row) * stride;
+        for (int o = 0; o < stride; o += LANE_COUNT)
+        {
+            Lanes acc = loadLanes(bias + o);
+            for (int i = 0; i < layer.inSize; ++i)
+                acc = multiplyAddLanes(broadcastLanes(x[i]), loadLanes(weights + static_cast<size_t>(i) * stride + o), acc);
+            storeLanes(y + o, acc);
+        }
+    }
+
+    float* end = out + static_cast<size_t>(batch) * stride;
+    switch (layer.activation)
+    {
+    case MLP_ACTIVATION_TANH:
+        for (float* y = out; y < end; ++y)
+            *y = std::tanh(*y);
+        break;
+    case MLP_ACTIVATION_RELU:
+        for (float* y = out; y < end; ++y)
+            *y = std::max(*y, 0.0f);
+        break;
+    case MLP_ACTIVATION_NONE:
+        break;
+    }
+}
+
+void MlpPolicy::forward(const float* in, int batch, float* out) const
+{
+    if (batch <= 0)
+        return;
+
+    // Ping-pong between two scratch buffers; per thread so concurrent callers don't collide
+    thread_local std::vector<float> scratch[2];
+    thread_local std::vector<float> normalized;
+    size_t size = static_cast<size_t>(batch) * maxStride;
+    for (auto& buffer : scratch)
+    {
+        if (buffer.size() < size)
+            buffer.resize(size);
+    }
+
+    const float* current = in;
+    int currentStride = getInputSize();
+
+    if (!inputMean.empty())
+    {
+        normalized.resize(static_cast<size_t>(batch) * currentStride);
+        for (int b = 0; b < batch; ++b)
+        {
+            const float* x = in + static_cast<size_t>(b) * currentStride;
+            float* y = normalized.data() + static_cast<size_t>(b) * currentStride;
+            for (int i = 0; i < currentStride; ++i)
+                y[i] = std::clamp((x[i] - inputMean[i]) * inputScale[i], -inputClip, inputClip);
+        }
+        current = normalized.data();
+    }
+    for (size_t l = 0; l < layers.size(); ++l)
+    {
+        float* next = scratch[l % 2].data();
+        evaluateLayer(layers[l], current, currentStride, batch, next);
+        current = next;
+        currentStride = layers[l].stride;
+    }
+
+    const int outputSize = getOutputSize();
+    for (int b = 0; b < batch; ++b)
+        std::copy(current + static_cast<size_t>(b) * currentStride,
+                  current + static_cast<size_t>(b) * currentStride + outputSize,
+                  out + static_cast<size_t>(b) * outputSize);
+}
@@ -0,0 +1,63 @@
+#ifndef MLP_POLICY_H
+
+#define MLP_POLICY_H
+
+#include <memory>
+#include <vector>
+
+enum MlpActivation
+{
+    MLP_ACTIVATION_NONE = 0,
+    MLP_ACTIVATION_TANH = 1,
+    MLP_ACTIVATION_RELU = 2,
+};
+
+// Feed-forward policy network of dense layers, e.g. an exported SB3 MlpPolicy
+// actor (see racegym/policy_export.py). Immutable once loaded, so one instance
+// serves any number of vehicles and threads.
+//
+// File format (little-endian): header {char magic[4] = "RGMP"; uint32 version;
+// uint32 numLayers; uint32 flags}, then per layer {uint32 inSize; uint32 outSize;
+// uint32 activation; uint32 reserved}, float weights[outSize][inSize], float bias[outSize].
+// With MLP_POLICY_NORMALIZE_INPUT set, the layers are followed by float mean[inSize],
+// float scale[inSize] and float clip: inputs become clamp((x - mean) * scale, -clip, clip),
+// matching SB3's VecNormalize.
+const unsigned MLP_POLICY_NORMALIZE_INPUT = 1u << 0;
+
+class MlpPolicy
+{
+public:
+    // nullptr if the file is missing or malformed
+    static std::shared_ptr<const MlpPolicy> load(const char* path);
+
+    int getInputSize() const { return layers.front().inSize; }
+    int getOutputSize() const { return layers.back().outSize; }
+
+    // Evaluate batch inputs at once: in is [batch][getInputSize()], out is [batch][getOutputSize()]
+    void forward(const float* in, int batch, float* out) const;
+
+private:
+    struct Layer
+    {
+        int inSize;
+        int outSize;
+        int stride; // outSize rounded up to a whole number of SIMD lanes
+        MlpActivation activation;
+        std::vector<float> weights; // Transposed, [inSize][stride], zero padded
+        std::vector<float> bias;    // [stride], zero padded
+    };
+
+    std::vector<Layer> layers;
+    int maxStride;
+
+    // Input normalization; empty when the inputs are used as given
+    std::vector<float> inputMean;
+    std::vector<float> inputScale;
+    float inputClip;
+
+    MlpPolicy() : maxStride(0), inputClip(0.0f) {}
+
+    static void evaluateLayer(const Layer& layer, const float* in, int inStride, int batch, float* out);
+};
+
+#endif // MLP_POLICY_H
@@ -0,0 +1,39 @@
+#include "observation.h"
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include "track.h"
+#include "vehicle.h"
+
+int computeObservation(const Track& track, const Vehicle& vehicle, float* out, int maxFloats)
+{
+    const PhysicsBody& body = *vehicle.body;
+
+    // Current track parameter
+    glm::vec3 vehiclePos = body.position;
+    float currentT = track.getClosestT(glm::vec2(vehiclePos.x, vehiclePos.z));
+
+    // Generate waypoints (20 pairs => 40 points)
+    std::vector<glm::vec3> waypoints = track.getWaypoints(currentT, OBSERVATION_WAYPOINTS, OBSERVATION_WAYPOINT_SPACING);
+
+    // Vehicle frame
+    glm::vec3 forward = glm::normalize(body.orientation * glm::vec3(0.0f, 0.0f, 1.0f));
+    glm::vec3 right   = glm::normalize(body.orientation * glm::vec3(1.0f, 0.0f, 0.0f));
+
+    int idx = 0;
+    for (const auto& wp : waypoints) {
+        if (idx + 2 > maxFloats) break;
+        glm::vec3 rel = wp - vehiclePos;
+        out[idx++] = glm::dot(rel, right);    // local x (lateral)
+        out[idx++] = glm::dot(rel, forward);  // local z (longitudinal)
+    }
+
+    if (idx + 3 <= maxFloats) {
+        glm::vec3 vel = body.velocity;
+        out[idx++] = glm::dot(vel, forward); // longitudinal velocity
+        out[idx++] = glm::dot(vel, right);   // lateral velocity
+        out[idx++] = body.angularVelocity.y; // yaw rate
+    }
+
+    return idx;
+}
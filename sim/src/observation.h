@@ -0,0 +1,16 @@
+#ifndef OBSERVATION_H
+#define OBSERVATION_H
+
+class Track;
+class Vehicle;
+
+// Observation layout: 20 left/right waypoint pairs ahead of the vehicle as (local x, local z),
+// then longitudinal velocity, lateral velocity and yaw rate, all in the vehicle frame
+const int OBSERVATION_WAYPOINTS = 20;
+const float OBSERVATION_WAYPOINT_SPACING = 0.1f; // Track parameter between waypoint pairs
+const int OBSERVATION_SIZE = OBSERVATION_WAYPOINTS * 2 * 2 + 3;
+
+// Write up to maxFloats values of the vehicle's observation; returns the number written
+int computeObservation(const Track& track, const Vehicle& vehicle, float* out, int maxFloats);
+
+#endif // OBSERVATION_H
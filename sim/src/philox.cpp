@@ -0,0 +1,187 @@
+#include "philox.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PHILOX_USE_SSE2
+#endif
+
+namespace
+{
+    const uint32_t PHILOX_M0 = 0xD2511F53u;
+    const uint32_t PHILOX_M1 = 0xCD9E8D57u;
+    const uint32_t PHILOX_W0 = 0x9E3779B9u;
+    const uint32_t PHILOX_W1 = 0xBB67AE85u;
+    const int PHILOX_ROUNDS = 10;
+
+    // Blocks generated together by fillUniform, one per 32-bit lane of a vector
+    const int PHILOX_BATCH = 8;
+
+    inline void philoxRound(uint32_t& c0, uint32_t& c1, uint32_t& c2, uint32_t& c3, uint32_t k0, uint32_t k1)
+    {
+        uint64_t p0 = static_cast<uint64_t>(PHILOX_M0) * c0;
+        uint64_t p1 = static_cast<uint64_t>(PHILOX_M1) * c2;
+        uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+        uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+        c1 = static_cast<uint32_t>(p1);
+        c3 = static_cast<uint32_t>(p0);
+        c0 = n0;
+        c2 = n2;
+    }
+
+    // Minimal SIMD vocabulary for the batched rounds: widest 32-bit integer vector the
+    // build targets. Compilers won't vectorise the 32x32->64 bit multiplies on their own,
+    // so the high and low halves come from mul_epu32 on the even and odd lanes.
+#if defined(__AVX2__)
+    typedef __m256i Lanes;
+    const int LANE_COUNT = 8;
+    inline Lanes loadLanes(const uint32_t* p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)); }
+    inline void storeLanes(uint32_t* p, Lanes v) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+    inline Lanes broadcastLanes(uint32_t x) { return _mm256_set1_epi32(static_cast<int>(x)); }
+    inline Lanes xorLanes(Lanes a, Lanes b) { return _mm256_xor_si256(a, b); }
+    inline void multiplyHiLoLanes(Lanes a, Lanes m, Lanes& hi, Lanes& lo)
+    {
+        const Lanes lowHalves = _mm256_set1_epi64x(0xFFFFFFFF);
+        Lanes even = _mm256_mul_epu32(a, m);
+        Lanes odd = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), m);
+        hi = _mm256_or_si256(_mm256_srli_epi64(even, 32), _mm256_andnot_si256(lowHalves, odd));
+        lo = _mm256_or_si256(_mm256_and_si256(even, lowHalves), _mm256_slli_epi64(odd, 32));
+    }
+#elif defined(PHILOX_USE_SSE2)
+    typedef __m128i Lanes;
+    const int LANE_COUNT = 4;
+    inline Lanes loadLanes(const uint32_t* p) { return _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)); }
+    inline void storeLanes(uint32_t* p, Lanes v) { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+    inline Lanes broadcastLanes(uint32_t x) { return _mm_set1_epi32(static_cast<int>(x)); }
+    inline Lanes xorLanes(Lanes a, Lanes b) { return _mm_xor_si128(a, b); }
+    inline void multiplyHiLoLanes(Lanes a, Lanes m, Lanes& hi, Lanes& lo)
+    {
+        const Lanes lowHalves = _mm_set_epi32(0, -1, 0, -1);
+        Lanes even = _mm_mul_epu32(a, m);
+        Lanes odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), m);
+        hi = _mm_or_si128(_mm_srli_epi64(even, 32), _mm_andnot_si128(lowHalves, odd));
+        lo = _mm_or_si128(_mm_and_si128(even, lowHalves), _mm_slli_epi64(odd, 32));
+    }
+#else
+    typedef uint32_t Lanes;
+    const int LANE_COUNT = 1;
+    inline Lanes loadLanes(const uint32_t* p) { return *p; }
+    inline void storeLanes(uint32_t* p, Lanes v) { *p = v; }
+    inline Lanes broadcastLanes(uint32_t x) { return x; }
+    inline Lanes xorLanes(Lanes a, Lanes b) { return a ^ b; }
+    inline void multiplyHiLoLanes(Lanes a, Lanes m, Lanes& hi, Lanes& lo)
+    {
+        uint64_t product = static_cast<uint64_t>(a) * m;
+        hi = static_cast<uint32_t>(product >> 32);
+        lo = static_cast<uint32_t>(product);
+    }
+#endif
+
+    static_assert(PHILOX_BATCH % LANE_COUNT == 0, "a batch must hold whole SIMD vectors");
+
+    // philoxRound on LANE_COUNT independent blocks at once
+    inline void philoxRoundLanes(Lanes& c0, Lanes& c1, Lanes& c2, Lanes& c3, Lanes k0, Lanes k1)
+    {
+        Lanes hi0, lo0, hi1, lo1;
+        multiplyHiLoLanes(c0, broadcastLanes(PHILOX_M0), hi0, lo0);
+        multiplyHiLoLanes(c2, broadcastLanes(PHILOX_M1), hi1, lo1);
+        c0 = xorLanes(xorLanes(hi1, c1), k0);
+        c2 = xorLanes(xorLanes(hi0, c3), k1);
+        c1 = lo1;
+        c3 = lo0;
+    }
+}
+
+void philox4x32(const uint32_t counter[4], uint64_t key, uint32_t out[4])
+{
+    uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2], c3 = counter[3];
+    uint32_t k0 = static_cast<uint32_t>(key), k1 = static_cast<uint32_t>(key >> 32);
+    for (int round = 0; round < PHILOX_ROUNDS; ++round)
+    {
+        philoxRound(c0, c1, c2, c3, k0, k1);
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+RandomStream::RandomStream(uint64_t seed, uint32_t env, uint32_t episode, uint32_t step)
+    : key(seed), counter{0, step, episode, env}, buffer{0, 0, 0, 0}, used(4)
+{
+}
+
+uint32_t RandomStream::nextUint32()
+{
+    if (used == 4)
+    {
+        philox4x32(counter, key, buffer);
+        ++counter[0];
+        used = 0;
+    }
+    return buffer[used++];
+}
+
+uint64_t RandomStream::nextUint64()
+{
+    uint64_t low = nextUint32();
+    return low | (static_cast<uint64_t>(nextUint32()) << 32);
+}
+
+void RandomStream::fillUniform(float* out, int count)
+{
+    int i = 0;
+    // Finish the current block first so the values match repeated uniform() calls
+    while (i < count && used < 4)
+    {
+        out[i++] = uniform();
+    }
+
+    const uint32_t k0 = static_cast<uint32_t>(key), k1 = static_cast<uint32_t>(key >> 32);
+    while (count - i >= 4 * PHILOX_BATCH)
+    {
+        uint32_t c0[PHILOX_BATCH], c1[PHILOX_BATCH], c2[PHILOX_BATCH], c3[PHILOX_BATCH];
+        for (int lane = 0; lane < PHILOX_BATCH; ++lane)
+        {
+            c0[lane] = counter[0] + static_cast<uint32_t>(lane);
+            c1[lane] = counter[1];
+            c2[lane] = counter[2];
+            c3[lane] = counter[3];
+        }
+
+        for (int lane = 0; lane < PHILOX_BATCH; lane += LANE_COUNT)
+        {
+            Lanes x0 = loadLanes(c0 + lane), x1 = loadLanes(c1 + lane);
+            Lanes x2 = loadLanes(c2 + lane), x3 = loadLanes(c3 + lane);
+            uint32_t roundK0 = k0, roundK1 = k1;
+            for (int round = 0; round < PHILOX_ROUNDS; ++round)
+            {
+                philoxRoundLanes(x0, x1, x2, x3, broadcastLanes(roundK0), broadcastLanes(roundK1));
+                roundK0 += PHILOX_W0;
+                roundK1 += PHILOX_W1;
+            }
+            storeLanes(c0 + lane, x0);
+            storeLanes(c1 + lane, x1);
+            storeLanes(c2 + lane, x2);
+            storeLanes(c3 + lane, x3);
+        }
+
+        for (int lane = 0; lane < PHILOX_BATCH; ++lane)
+        {
+            out[i + 4 * lane + 0] = uniformFromBits(c0[lane]);
+            out[i + 4 * lane + 1] = uniformFromBits(c1[lane]);
+            out[i + 4 * lane + 2] = uniformFromBits(c2[lane]);
+            out[i + 4 * lane + 3] = uniformFromBits(c3[lane]);
+        }
+        counter[0] += PHILOX_BATCH;
+        i += 4 * PHILOX_BATCH;
+    }
+
+    while (i < count)
+    {
+        out[i++] = uniform();
+    }
+}
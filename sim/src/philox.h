@@ -0,0 +1,43 @@
+#ifndef PHILOX_H
+
+#define PHILOX_H
+
+#include <cstdint>
+
+// Philox4x32-10 counter-based generator (Salmon et al., "Parallel Random Numbers: As
+// Easy as 1, 2, 3"). Each output block is a pure function of a 128-bit counter and a
+// 64-bit key, so any thread can draw any part of any stream without shared state, and
+// results don't depend on which thread draws them or in what order.
+void philox4x32(const uint32_t counter[4], uint64_t key, uint32_t out[4]);
+
+// Uniform float in [0, 1) from the top 24 bits of a draw
+inline float uniformFromBits(uint32_t bits)
+{
+    return static_cast<float>(bits >> 8) * (1.0f / 16777216.0f);
+}
+
+// The stream of draws for one (seed, env, episode, step). The seed is the key and the
+// other three fill the counter, with its last word counting blocks within the stream,
+// so distinct tuples give independent streams. A stream is a cheap value; make a new
+// one wherever draws are needed instead of passing generators around.
+class RandomStream
+{
+public:
+    RandomStream(uint64_t seed, uint32_t env, uint32_t episode, uint32_t step);
+
+    uint32_t nextUint32();
+    uint64_t nextUint64();
+    float uniform() { return uniformFromBits(nextUint32()); }
+    float uniform(float lo, float hi) { return lo + (hi - lo) * uniform(); }
+
+    // The next count uniform [0, 1) floats, generated several blocks at a time
+    void fillUniform(float* out, int count);
+
+private:
+    uint64_t key;
+    uint32_t counter[4]; // block, step, episode, env
+    uint32_t buffer[4];  // Current block
+    int used;            // Draws taken from buffer
+};
+
+#endif // PHILOX_H
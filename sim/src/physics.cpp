@@ -1,4 +1,6 @@
 #include "physics.h"
+#include <cfloat>
+#include <cmath>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/quaternion.hpp>
 #include <iostream>
@@ -18,24 +20,9 @@ void PhysicsBody::applyForceAtPoint(const glm::vec3 &force, const glm::vec3 &poi
 
 void PhysicsBody::step(float deltaTime)
 {
-    if(mass > 0.0f)
-    {
-        glm::vec3 acceleration = accumulatedForce / mass;
-        velocity += acceleration * deltaTime;
-        position += velocity * deltaTime;
-
-        glm::vec3 angularAcceleration = accumulatedTorque / inertia;
-        angularVelocity += angularAcceleration * deltaTime;
-        
-        // Integrate angular velocity into quaternion orientation
-        glm::quat angularVelQuat(0.0f, angularVelocity.x, angularVelocity.y, angularVelocity.z);
-        orientation += 0.5f * angularVelQuat * orientation * deltaTime;
-        orientation = glm::normalize(orientation);
-    }
-
-    // Clear forces and torques for next step
-    accumulatedForce = glm::vec3(0.0f);
-    accumulatedTorque = glm::vec3(0.0f);
+    BodyState<float> state = getBodyState();
+    integrateBody(state, mass, inertia, deltaTime);
+    setBodyState(state);
 }
 
 glm::mat4 PhysicsBody::getModelMatrix() const
@@ -47,16 +34,53 @@ glm::mat4 PhysicsBody::getModelMatrix() const
 
 void PhysicsWorld::stepSimulation(float deltaTime)
 {
-    for(auto body : bodies)
+    stepBodies(0, getNumBodies(), deltaTime);
+}
+
+void PhysicsWorld::stepBodies(int first, int count, float deltaTime)
+{
+    for(int i = first; i < first + count; ++i)
     {
+        PhysicsBody *body = bodies[i];
         body->applyForce(gravity * body->mass);
         body->step(deltaTime);
     }
 }
 
+bool PhysicsWorld::isStateValid() const
+{
+    // Compare magnitudes against limits without branching, so the check vectorises;
+    // NaN fails every comparison and infinity exceeds every limit, including FLT_MAX
+    // for the pending force and torque, which only need to be finite
+    const float limits[19] = {
+        BODY_POSITION_LIMIT, BODY_POSITION_LIMIT, BODY_POSITION_LIMIT,
+        1.5f, 1.5f, 1.5f, 1.5f, // Unit quaternion, with slack for rounding
+        BODY_VELOCITY_LIMIT, BODY_VELOCITY_LIMIT, BODY_VELOCITY_LIMIT,
+        BODY_ANGULAR_VELOCITY_LIMIT, BODY_ANGULAR_VELOCITY_LIMIT, BODY_ANGULAR_VELOCITY_LIMIT,
+        FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX, FLT_MAX
+    };
+
+    bool valid = true;
+    for(const PhysicsBody *body : bodies)
+    {
+        const glm::vec3 &force = body->getAccumulatedForce();
+        const glm::vec3 &torque = body->getAccumulatedTorque();
+        const float values[19] = {
+            body->position.x, body->position.y, body->position.z,
+            body->orientation.w, body->orientation.x, body->orientation.y, body->orientation.z,
+            body->velocity.x, body->velocity.y, body->velocity.z,
+            body->angularVelocity.x, body->angularVelocity.y, body->angularVelocity.z,
+            force.x, force.y, force.z, torque.x, torque.y, torque.z
+        };
+        for(int i = 0; i < 19; ++i)
+            valid &= std::abs(values[i]) <= limits[i];
+    }
+    return valid;
+}
+
 PhysicsBody* PhysicsWorld::addBody(CollisionShape const *shape, float mass, const glm::vec3 &position, const glm::quat &orientation)
 {
-    PhysicsBody *body = new PhysicsBody(shape, mass, position, orientation);
+    PhysicsBody *body = arena.create<PhysicsBody>(shape, mass, position, orientation);
     bodies.push_back(body);
     return body;
     
@@ -68,6 +92,12 @@ void PhysicsWorld::removeBody(PhysicsBody* body)
     if(it != bodies.end())
     {
         bodies.erase(it);
-        delete body;
+        arena.destroy(body);
     }
+}
+
+void PhysicsWorld::resetArena()
+{
+    if(bodies.empty())
+        arena.reset();
 }
\ No newline at end of file
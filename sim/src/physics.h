@@ -5,6 +5,9 @@
 #include <glm/glm.hpp>
 #include <vector>
 #include <glm/gtc/quaternion.hpp>
+#include "arena.h"
+#include "cache_line.h"
+#include "scalar_math.h"
 
 enum CollisionShapeType
 {
@@ -34,7 +37,43 @@ public:
     }
 };
 
-struct PhysicsBody
+// Dynamic state of a rigid body over scalar type T, including the force and
+// torque accumulated since the last step
+template<typename T>
+struct BodyState
+{
+    Vec3<T> position;
+    Quat<T> orientation;
+    Vec3<T> velocity;
+    Vec3<T> angularVelocity;
+    Vec3<T> force;
+    Vec3<T> torque;
+};
+
+// Semi-implicit Euler step of a body with a diagonal inertia tensor; clears the accumulators
+template<typename T>
+void integrateBody(BodyState<T> &state, float mass, const glm::vec3 &inertia, float deltaTime)
+{
+    if(mass > 0.0f)
+    {
+        Vec3<T> acceleration = state.force / T(mass);
+        state.velocity += acceleration * T(deltaTime);
+        state.position += state.velocity * T(deltaTime);
+
+        Vec3<T> angularAcceleration = divide(state.torque, inertia);
+        state.angularVelocity += angularAcceleration * T(deltaTime);
+
+        // Integrate angular velocity into quaternion orientation
+        Quat<T> angularVelQuat(T(0.0f), state.angularVelocity.x, state.angularVelocity.y, state.angularVelocity.z);
+        state.orientation = state.orientation + angularVelQuat * T(0.5f) * state.orientation * T(deltaTime);
+        state.orientation = normalize(state.orientation);
+    }
+
+    state.force = Vec3<T>();
+    state.torque = Vec3<T>();
+}
+
+struct alignas(CACHE_LINE_SIZE) PhysicsBody
 {
 public:
     float mass;
@@ -43,7 +82,7 @@ public:
     glm::vec3 velocity;
     glm::quat orientation;
     glm::vec3 angularVelocity;
-    CollisionShape const *shape;
+    CollisionShape const *shape; // Owned by the world's arena
 
     PhysicsBody(CollisionShape const *shape, float mass, const glm::vec3 &position, const glm::quat &orientation)
         : shape(shape), mass(mass), position(position), velocity(0.0f),
@@ -54,16 +93,43 @@ public:
             inertia = shape->getInertiaTensor(mass);
     }
 
-    ~PhysicsBody()
-    {
-        delete shape;
-    }
-
     void applyForce(const glm::vec3 &force);
     void applyForceAtPoint(const glm::vec3 &force, const glm::vec3 &point);
     void step(float deltaTime);
     glm::mat4 getModelMatrix() const;
 
+    // Inline so the float dynamics compile down to plain loads and stores of the body
+    BodyState<float> getBodyState() const
+    {
+        BodyState<float> state;
+        state.position = Vec3<float>(position);
+        state.orientation = Quat<float>(orientation);
+        state.velocity = Vec3<float>(velocity);
+        state.angularVelocity = Vec3<float>(angularVelocity);
+        state.force = Vec3<float>(accumulatedForce);
+        state.torque = Vec3<float>(accumulatedTorque);
+        return state;
+    }
+
+    void setBodyState(const BodyState<float> &state)
+    {
+        position = state.position.toGlm();
+        orientation = state.orientation.toGlm();
+        velocity = state.velocity.toGlm();
+        angularVelocity = state.angularVelocity.toGlm();
+        accumulatedForce = state.force.toGlm();
+        accumulatedTorque = state.torque.toGlm();
+    }
+
+    // Forces applied since the last step; part of the body state between steps
+    const glm::vec3& getAccumulatedForce() const { return accumulatedForce; }
+    const glm::vec3& getAccumulatedTorque() const { return accumulatedTorque; }
+    void setAccumulated(const glm::vec3 &force, const glm::vec3 &torque)
+    {
+        accumulatedForce = force;
+        accumulatedTorque = torque;
+    }
+
 private:
     glm::vec3 accumulatedForce;
     glm::vec3 accumulatedTorque;
@@ -84,20 +150,40 @@ struct CollisionInfo
     std::vector<ContactPoint> contactPoints;
 };
 
+// Bodies further from the origin or faster than this are treated as diverged; a
+// healthy car stays orders of magnitude inside them
+const float BODY_POSITION_LIMIT = 1.0e5f;         // m
+const float BODY_VELOCITY_LIMIT = 1.0e3f;         // m/s
+const float BODY_ANGULAR_VELOCITY_LIMIT = 1.0e3f; // rad/s
+
 class PhysicsWorld
 {
 public:
     glm::vec3 gravity = glm::vec3(0.0f, -9.81f, 0.0f);
 
     void stepSimulation(float deltaTime);
-
+    // Integrate bodies [first, first + count); bodies don't interact, so disjoint
+    // ranges can be stepped concurrently
+    void stepBodies(int first, int count, float deltaTime);
+    int getNumBodies() const { return static_cast<int>(bodies.size()); }
+    // Whether every body's state is finite and within the limits above
+    bool isStateValid() const;
+
+    // The shape must come from getArena()
     PhysicsBody* addBody(CollisionShape const *shape, float mass=0.0f, const glm::vec3 &position=glm::vec3(0.0f), const glm::quat &orientation=glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
     void removeBody(PhysicsBody* body);
 
     void clear();
 
+    // Memory for everything simulated in this world: bodies, their shapes and the
+    // vehicles built on them. Removing a body doesn't return its memory.
+    Arena& getArena() { return arena; }
+    // Reclaim the arena wholesale; does nothing while any body is left
+    void resetArena();
+
 private:
     std::vector<PhysicsBody*> bodies;
+    Arena arena;
 };
 
 #endif // PHYSICS_H
\ No newline at end of file
@@ -9,7 +9,9 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/quaternion.hpp>
 #include <cmath>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include <iostream>
 
@@ -32,6 +34,16 @@ struct Camera {
     Camera();
 };
 
+const int WHEEL_RENDER_RESOLUTION = 12; // Number of points around the wheel
+const float WHEEL_THICKNESS = 0.25f; // Thickness of the wheel in meters
+
+// Render-side state of one track geometry, keyed by its TrackData. The weak
+// reference tells a live entry apart from a new track loaded at the same address.
+struct TrackComponent {
+    std::weak_ptr<const TrackData> data;
+    Mesh mesh;
+};
+
 struct RenderContext {
     GLFWwindow* window;
     unsigned int shaderProgram;
@@ -42,6 +54,8 @@ struct RenderContext {
     Camera camera;
     double lastCameraTime;
     Mesh groundPlaneMesh, waypointMesh;
+    Mesh chassisMesh, wheelMesh; // Shared by every vehicle
+    std::unordered_map<const TrackData*, TrackComponent> tracks;
     RenderContext();
 };
 
@@ -109,6 +123,145 @@ static unsigned int linkProgram(unsigned int vs, unsigned int fs) {
     return p;
 }
 
+static Mesh createChassisMesh() {
+    float w = VEHICLE_DIMENSIONS.x;
+    float h = VEHICLE_DIMENSIONS.y;
+    float l = VEHICLE_DIMENSIONS.z;
+    float vertices[] = {
+        -w/2, -h/2, -l/2,
+         w/2, -h/2, -l/2,
+         w/2,  h/2, -l/2,
+        -w/2,  h/2, -l/2,
+        -w/2, -h/2,  l/2,
+         w/2, -h/2,  l/2,
+         w/2,  h/2,  l/2,
+        -w/2,  h/2,  l/2,
+    };
+    unsigned int indices[] = {
+        0, 1, 2, 2, 3, 0,
+        4, 5, 6, 6, 7, 4,
+        0, 1, 5, 5, 4, 0,
+        2, 3, 7, 7, 6, 2,
+        0, 3, 7, 7, 4, 0,
+        1, 2, 6, 6, 5, 1,
+    };
+    return Renderer::createMesh(vertices, 8, indices, 36);
+}
+
+static Mesh createWheelMesh() {
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+
+    const float radius = WHEEL_RADIUS;
+    const float thickness = WHEEL_THICKNESS;
+
+    // Two circles, interleaved front/back
+    for (int i = 0; i < WHEEL_RENDER_RESOLUTION; ++i) {
+        float angle = 2.0f * 3.14159265359f * i / WHEEL_RENDER_RESOLUTION;
+        float x = radius * glm::cos(angle);
+        float z = radius * glm::sin(angle);
+        vertices.insert(vertices.end(), { x, -thickness / 2.0f, z });
+        vertices.insert(vertices.end(), { x, thickness / 2.0f, z });
+    }
+
+    // Sides
+    for (int i = 0; i < WHEEL_RENDER_RESOLUTION; ++i) {
+        unsigned int next = (i + 1) % WHEEL_RENDER_RESOLUTION;
+        unsigned int frontCurr = i * 2, backCurr = i * 2 + 1;
+        unsigned int frontNext = next * 2, backNext = next * 2 + 1;
+        indices.insert(indices.end(), { frontCurr, frontNext, backCurr });
+        indices.insert(indices.end(), { backCurr, frontNext, backNext });
+    }
+
+    // Caps around a centre vertex on each side
+    unsigned int centerFront = static_cast<unsigned int>(vertices.size() / 3);
+    vertices.insert(vertices.end(), { 0.0f, -thickness / 2.0f, 0.0f });
+    unsigned int centerBack = static_cast<unsigned int>(vertices.size() / 3);
+    vertices.insert(vertices.end(), { 0.0f, thickness / 2.0f, 0.0f });
+    for (int i = 0; i < WHEEL_RENDER_RESOLUTION; ++i) {
+        unsigned int next = (i + 1) % WHEEL_RENDER_RESOLUTION;
+        indices.insert(indices.end(), { centerFront, static_cast<unsigned int>(i * 2), next * 2 });
+        indices.insert(indices.end(), { centerBack, next * 2 + 1, static_cast<unsigned int>(i * 2 + 1) });
+    }
+
+    return Renderer::createMesh(vertices.data(), static_cast<int>(vertices.size() / 3),
+                                indices.data(), static_cast<int>(indices.size()));
+}
+
+// Flat strip between the track edges, drawn as GL_TRIANGLE_STRIP
+static Mesh createTrackMesh(const TrackData& data) {
+    int numSegments = data.getNumSegments();
+    int resolution = numSegments * 20; // 20 samples per segment
+
+    std::vector<float> vertices;
+    vertices.reserve(resolution * 6);
+    for (int i = 0; i < resolution; ++i) {
+        // LHS
+        float t0 = static_cast<float>(i) / static_cast<float>(resolution - 1) * static_cast<float>(numSegments);
+        glm::vec2 p = data.getPosition(t0) + data.getNormal(t0) * TRACK_WIDTH / 2.0f;
+        vertices.insert(vertices.end(), { p.x, 0.0f, p.y }); // Same height as ground plane
+
+        // RHS
+        float t1 = (static_cast<float>(i) + 0.5f) / static_cast<float>(resolution - 1) * static_cast<float>(numSegments);
+        p = data.getPosition(t1) - data.getNormal(t1) * TRACK_WIDTH / 2.0f;
+        vertices.insert(vertices.end(), { p.x, 0.0f, p.y });
+    }
+
+    std::vector<unsigned int> indices(resolution * 2);
+    for (unsigned int i = 0; i < indices.size(); ++i) {
+        indices[i] = i;
+    }
+
+    return Renderer::createMesh(vertices.data(), static_cast<int>(vertices.size() / 3),
+                                indices.data(), static_cast<int>(indices.size()));
+}
+
+// Mesh of a track's geometry, built the first time that geometry is drawn
+static const Mesh& getTrackMesh(RenderContext* ctx, const Track* track) {
+    const std::shared_ptr<const TrackData>& data = track->getData();
+    TrackComponent& component = ctx->tracks[data.get()];
+    if (component.data.lock() != data) {
+        Renderer::destroyMesh(component.mesh);
+        component.data = data;
+        component.mesh = createTrackMesh(*data);
+    }
+    return component.mesh;
+}
+
+// Drop the meshes of tracks that are no longer loaded anywhere
+static void pruneTrackMeshes(RenderContext* ctx) {
+    for (auto it = ctx->tracks.begin(); it != ctx->tracks.end();) {
+        if (it->second.data.expired()) {
+            Renderer::destroyMesh(it->second.mesh);
+            it = ctx->tracks.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+static void drawVehicle(RenderContext* ctx, const Vehicle* vehicle) {
+    const PhysicsBody* body = vehicle->body;
+    Renderer::drawMesh(ctx->chassisMesh, body->getModelMatrix(), glm::vec3(0.8f, 0.0f, 0.0f)); // Red color for vehicle
+
+    const Wheel* wheels = vehicle->getWheels();
+    const glm::mat4 bodyRotation = glm::mat4_cast(body->orientation);
+    const glm::vec3 suspAxisWorld = body->orientation * glm::vec3(0.0f, -1.0f, 0.0f);
+    for (int i = 0; i < 4; ++i) {
+        // Mount point pushed down the suspension axis by the current spring length
+        glm::vec3 mountWorld = body->position + body->orientation * wheels[i].localPosition;
+        float currentLength = wheels[i].restLength - wheels[i].compression;
+        glm::vec3 wheelPosition = mountWorld + suspAxisWorld * currentLength;
+
+        glm::mat4 wheelModel = glm::translate(glm::mat4(1.0f), wheelPosition) * bodyRotation;
+        wheelModel = glm::rotate(wheelModel, glm::radians(90.0f), glm::vec3(0.0f, 0.0f, 1.0f));
+        wheelModel = glm::rotate(wheelModel, wheels[i].steerAngle, glm::vec3(1.0f, 0.0f, 0.0f));
+        wheelModel = glm::rotate(wheelModel, wheels[i].rollAngle, glm::vec3(0.0f, 1.0f, 0.0f));
+
+        Renderer::drawMesh(ctx->wheelMesh, wheelModel, glm::vec3(0.0f, 0.0f, 0.0f)); // Black color for wheels
+    }
+}
+
 static bool initGraphics(RenderContext* ctx) {
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
         return false;
@@ -155,6 +308,9 @@ static bool initGraphics(RenderContext* ctx) {
     };
     ctx->waypointMesh = Renderer::createMesh(cubeVertices, 8, cubeIndices, 36);
 
+    ctx->chassisMesh = createChassisMesh();
+    ctx->wheelMesh = createWheelMesh();
+
     return true;
 }
 
@@ -184,12 +340,13 @@ static void renderScene(RenderContext* ctx, Track* track, const std::vector<Vehi
     Renderer::drawMesh(ctx->groundPlaneMesh, glm::mat4(1.0f), glm::vec3(144.0f/255.0f, 238.0f/255.0f, 144.0f/255.0f));
     glDisable(GL_POLYGON_OFFSET_FILL);
 
+    pruneTrackMeshes(ctx);
     if (track) {
-        track->draw(ctx->locModel, ctx->locColor);
+        Renderer::drawMesh(getTrackMesh(ctx, track), glm::mat4(1.0f), glm::vec3(0.2f, 0.2f, 0.2f), GL_TRIANGLE_STRIP);
     }
 
     for (auto vehicle : vehicles) {
-        vehicle->draw(ctx->locModel, ctx->locColor);
+        drawVehicle(ctx, vehicle);
     }
 
     if (track && !vehicles.empty()) {
@@ -210,6 +367,12 @@ static void renderScene(RenderContext* ctx, Track* track, const std::vector<Vehi
 static void cleanupGraphics(RenderContext* ctx) {
     Renderer::destroyMesh(ctx->groundPlaneMesh);
     Renderer::destroyMesh(ctx->waypointMesh);
+    Renderer::destroyMesh(ctx->chassisMesh);
+    Renderer::destroyMesh(ctx->wheelMesh);
+    for (auto& entry : ctx->tracks) {
+        Renderer::destroyMesh(entry.second.mesh);
+    }
+    ctx->tracks.clear();
     if (ctx->shaderProgram) { glDeleteProgram(ctx->shaderProgram); ctx->shaderProgram = 0; }
 }
 
@@ -293,7 +456,11 @@ RenderContext::RenderContext()
       locView(-1),
       locProjection(-1),
       locColor(-1),
-      lastCameraTime(0.0) {}
+      lastCameraTime(0.0),
+      groundPlaneMesh(),
+      waypointMesh(),
+      chassisMesh(),
+      wheelMesh() {}
 
 
 bool Renderer::init() {
@@ -0,0 +1,117 @@
+#include "rollout.h"
+#include <algorithm>
+#include <vector>
+#include <glm/glm.hpp>
+#include "physics.h"
+#include "sim_context.h"
+#include "thread_pool.h"
+#include "track.h"
+#include "vehicle.h"
+#include "vehicle_dynamics.h"
+
+namespace
+{
+    // Everything one candidate carries between steps, kept together for locality
+    struct Candidate
+    {
+        VehicleDynamicsState<float> dynamics;
+        glm::vec3 lastContactPoints[4];
+        bool hasContact[4];
+        float trackT;
+        double trackProgress;
+    };
+}
+
+void rolloutBatch(const Track* track, const Vehicle* source, const float* state, const float* actions,
+                  int numCandidates, int horizon, const RolloutCost& cost,
+                  float* outCosts, float* outFinalStates)
+{
+    // A vehicle in a private world supplies body and wheel parameters; it is never stepped
+    PhysicsWorld world;
+    Vehicle model(world, glm::vec3(0.0f), glm::vec3(0.0f));
+
+    Candidate initial;
+    initial.dynamics.load(state);
+    const Wheel* sourceWheels = source ? source->getWheels() : nullptr;
+    for (int i = 0; i < 4; ++i)
+    {
+        initial.lastContactPoints[i] = sourceWheels ? sourceWheels[i].lastContactPoint : glm::vec3(0.0f);
+        initial.hasContact[i] = sourceWheels ? sourceWheels[i].hasContact : false;
+    }
+    glm::vec2 startPosition(state[0], state[2]);
+    initial.trackT = track->getClosestT(startPosition);
+    initial.trackProgress = initial.trackT;
+
+    std::vector<Candidate> candidates(numCandidates, initial);
+    const float numSegments = static_cast<float>(track->getNumSegments());
+
+    ThreadPool::global().parallelFor(numCandidates, [&](int k) {
+        Candidate& candidate = candidates[k];
+        const float* sequence = actions + static_cast<size_t>(k) * horizon * VEHICLE_CONTROL_SIZE;
+        float total = 0.0f;
+        float previous[VEHICLE_CONTROL_SIZE] = {};
+
+        for (int step = 0; step < horizon; ++step)
+        {
+            const float* control = sequence + step * VEHICLE_CONTROL_SIZE;
+            float steer = std::clamp(control[0], -1.0f, 1.0f);
+            float throttle = std::clamp(control[1], 0.0f, 1.0f);
+            float brake = std::clamp(control[2], 0.0f, 1.0f);
+
+            // Penalise what the car actually gets, so out-of-range samples cost nothing extra
+            const float applied[VEHICLE_CONTROL_SIZE] = {steer, throttle, brake};
+            if (step > 0 && cost.controlRateWeight != 0.0f)
+            {
+                float rate = 0.0f;
+                for (int i = 0; i < VEHICLE_CONTROL_SIZE; ++i)
+                {
+                    float change = applied[i] - previous[i];
+                    rate += change * change;
+                }
+                total += cost.controlRateWeight * rate;
+            }
+            std::copy(applied, applied + VEHICLE_CONTROL_SIZE, previous);
+
+            double startProgress = candidate.trackProgress;
+            for (int substep = 0; substep < SUBSTEPS_PER_STEP; ++substep)
+            {
+                WheelContact contacts[4];
+                stepVehicleDynamics(candidate.dynamics, model, steer, throttle, brake, SUBSTEP_DELTA, contacts);
+                for (int i = 0; i < 4; ++i)
+                {
+                    candidate.hasContact[i] = contacts[i].hasContact;
+                    if (contacts[i].hasContact)
+                        candidate.lastContactPoints[i] = contacts[i].point;
+                }
+
+                // Same warm-started unwrapping as Vehicle::updateTrackProgress
+                const BodyState<float>& body = candidate.dynamics.body;
+                float newT = track->getClosestTNear(glm::vec2(body.position.x, body.position.z), candidate.trackT);
+                float delta = newT - candidate.trackT;
+                if (delta > numSegments / 2.0f)
+                    delta -= numSegments;
+                else if (delta < -numSegments / 2.0f)
+                    delta += numSegments;
+                candidate.trackT = newT;
+                candidate.trackProgress += delta;
+            }
+            total -= cost.progressWeight * static_cast<float>(candidate.trackProgress - startProgress);
+
+            const BodyState<float>& body = candidate.dynamics.body;
+            if (isCrashed(body.position.toGlm(), body.orientation.toGlm(), track))
+            {
+                total += cost.crashPenalty;
+                break;
+            }
+            if (isOffTrack(candidate.lastContactPoints, candidate.hasContact, track))
+            {
+                total += cost.offTrackPenalty;
+                break;
+            }
+        }
+
+        outCosts[k] = total;
+        if (outFinalStates)
+            candidate.dynamics.store(outFinalStates + static_cast<size_t>(k) * VEHICLE_STATE_SIZE);
+    });
+}
@@ -0,0 +1,32 @@
+#ifndef ROLLOUT_H
+#define ROLLOUT_H
+
+class Track;
+class Vehicle;
+
+// Weights of the native rollout cost. Per step a candidate pays
+// -progressWeight * (segments advanced) + controlRateWeight * |u_t - u_{t-1}|^2,
+// on the controls after clamping to their valid ranges.
+// Going off track or crashing ends the candidate's rollout with a one-off penalty,
+// like an episode termination.
+struct RolloutCost
+{
+    float progressWeight;
+    float offTrackPenalty;
+    float crashPenalty;
+    float controlRateWeight;
+};
+
+const RolloutCost DEFAULT_ROLLOUT_COST = {1.0f, 1.0f, 10.0f, 0.0f};
+
+// Roll out numCandidates control sequences of horizon steps from one vehicle state.
+// actions is [numCandidates][horizon][VEHICLE_CONTROL_SIZE]. Candidates live in one
+// contiguous array and are stepped in parallel on the global thread pool.
+// outFinalStates ([numCandidates][VEHICLE_STATE_SIZE]) may be null. When the state was
+// read from a live vehicle, pass it as source so candidates inherit its wheel contacts
+// for the off-track check; with null they start with no contacts.
+void rolloutBatch(const Track* track, const Vehicle* source, const float* state, const float* actions,
+                  int numCandidates, int horizon, const RolloutCost& cost,
+                  float* outCosts, float* outFinalStates);
+
+#endif // ROLLOUT_H
@@ -0,0 +1,134 @@
+#ifndef SCALAR_MATH_H
+
+#define SCALAR_MATH_H
+
+#include <cmath>
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
+
+// Minimal vector and quaternion types over an arbitrary scalar, for code that
+// must also run on dual numbers. glm only accepts IEEE float types, so the
+// templated dynamics use these and convert at the boundary; with T = float
+// every operation here compiles to the same arithmetic glm would emit.
+
+// Elementary functions for the scalar types the dynamics are instantiated with.
+// Other scalar types (see dual.h) specialize Ops; the forwarding templates
+// resolve the specialization at instantiation time.
+namespace scalar
+{
+    template<typename T>
+    struct Ops;
+
+    template<>
+    struct Ops<float>
+    {
+        static float value(float x) { return x; }
+        static float sqrt(float x) { return std::sqrt(x); }
+        static float sin(float x) { return std::sin(x); }
+        static float cos(float x) { return std::cos(x); }
+        static float atan(float x) { return std::atan(x); }
+        static float abs(float x) { return std::abs(x); }
+    };
+
+    template<typename T> float value(const T &x) { return Ops<T>::value(x); }
+    template<typename T> T sqrt(const T &x) { return Ops<T>::sqrt(x); }
+    template<typename T> T sin(const T &x) { return Ops<T>::sin(x); }
+    template<typename T> T cos(const T &x) { return Ops<T>::cos(x); }
+    template<typename T> T atan(const T &x) { return Ops<T>::atan(x); }
+    template<typename T> T abs(const T &x) { return Ops<T>::abs(x); }
+
+    template<typename T>
+    T max(const T &a, const T &b) { return a < b ? b : a; }
+
+    template<typename T>
+    T min(const T &a, const T &b) { return b < a ? b : a; }
+}
+
+template<typename T>
+struct Vec3
+{
+    T x, y, z;
+
+    Vec3() : x(0.0f), y(0.0f), z(0.0f) {}
+    Vec3(const T &x, const T &y, const T &z) : x(x), y(y), z(z) {}
+    explicit Vec3(const glm::vec3 &v) : x(v.x), y(v.y), z(v.z) {}
+
+    glm::vec3 toGlm() const { return glm::vec3(scalar::value(x), scalar::value(y), scalar::value(z)); }
+
+    Vec3 operator+(const Vec3 &o) const { return Vec3(x + o.x, y + o.y, z + o.z); }
+    Vec3 operator-(const Vec3 &o) const { return Vec3(x - o.x, y - o.y, z - o.z); }
+    Vec3 operator-() const { return Vec3(-x, -y, -z); }
+    Vec3 operator*(const T &s) const { return Vec3(x * s, y * s, z * s); }
+    Vec3 operator/(const T &s) const { return Vec3(x / s, y / s, z / s); }
+    Vec3 &operator+=(const Vec3 &o) { x += o.x; y += o.y; z += o.z; return *this; }
+};
+
+template<typename T>
+T dot(const Vec3<T> &a, const Vec3<T> &b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+template<typename T>
+Vec3<T> cross(const Vec3<T> &a, const Vec3<T> &b)
+{
+    return Vec3<T>(a.y * b.z - b.y * a.z,
+                   a.z * b.x - b.z * a.x,
+                   a.x * b.y - b.x * a.y);
+}
+
+template<typename T>
+T length(const Vec3<T> &v) { return scalar::sqrt(dot(v, v)); }
+
+// Component-wise division, used for the diagonal inertia tensor
+template<typename T>
+Vec3<T> divide(const Vec3<T> &a, const glm::vec3 &b) { return Vec3<T>(a.x / b.x, a.y / b.y, a.z / b.z); }
+
+template<typename T>
+struct Quat
+{
+    T w, x, y, z;
+
+    Quat() : w(1.0f), x(0.0f), y(0.0f), z(0.0f) {}
+    Quat(const T &w, const T &x, const T &y, const T &z) : w(w), x(x), y(y), z(z) {}
+    explicit Quat(const glm::quat &q) : w(q.w), x(q.x), y(q.y), z(q.z) {}
+
+    glm::quat toGlm() const { return glm::quat(scalar::value(w), scalar::value(x), scalar::value(y), scalar::value(z)); }
+
+    Quat operator+(const Quat &o) const { return Quat(w + o.w, x + o.x, y + o.y, z + o.z); }
+    Quat operator*(const T &s) const { return Quat(w * s, x * s, y * s, z * s); }
+
+    Quat operator*(const Quat &q) const
+    {
+        return Quat(w * q.w - x * q.x - y * q.y - z * q.z,
+                    w * q.x + x * q.w + y * q.z - z * q.y,
+                    w * q.y + y * q.w + z * q.x - x * q.z,
+                    w * q.z + z * q.w + x * q.y - y * q.x);
+    }
+
+    // Rotate a vector, same formulation as glm's quat * vec3
+    Vec3<T> operator*(const Vec3<T> &v) const
+    {
+        Vec3<T> u(x, y, z);
+        Vec3<T> uv = cross(u, v);
+        Vec3<T> uuv = cross(u, uv);
+        return v + ((uv * w) + uuv) * T(2.0f);
+    }
+};
+
+template<typename T>
+Quat<T> normalize(const Quat<T> &q)
+{
+    T len = scalar::sqrt(q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z);
+    if (len <= 0.0f)
+        return Quat<T>();
+    T oneOverLen = T(1.0f) / len;
+    return q * oneOverLen;
+}
+
+// Rotation of angle radians about the world up (+Y) axis
+template<typename T>
+Quat<T> angleAxisY(const T &angle)
+{
+    T half = angle * 0.5f;
+    return Quat<T>(scalar::cos(half), T(0.0f), scalar::sin(half), T(0.0f));
+}
+
+#endif // SCALAR_MATH_H
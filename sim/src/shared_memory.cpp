@@ -0,0 +1,183 @@
+#include "shared_memory.h"
+
+#include <cstdio>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+SharedMemoryRegion::SharedMemoryRegion()
+    : data(nullptr), size(0), owner(false)
+#ifdef _WIN32
+    , mappingHandle(nullptr)
+#endif
+{
+    name[0] = '\0';
+}
+
+SharedMemoryRegion::~SharedMemoryRegion()
+{
+    close();
+}
+
+#ifdef _WIN32
+
+static bool mapRegion(const char* name, size_t size, bool create, void*& outHandle, void*& outData)
+{
+    HANDLE mapping;
+    if (create)
+    {
+        mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                     static_cast<DWORD>(static_cast<unsigned long long>(size) >> 32),
+                                     static_cast<DWORD>(size & 0xFFFFFFFFull), name);
+    }
+    else
+    {
+        mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name);
+    }
+    if (!mapping)
+        return false;
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+    if (!view)
+    {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    outHandle = mapping;
+    outData = view;
+    return true;
+}
+
+bool SharedMemoryRegion::create(const char* regionName, size_t regionSize)
+{
+    close();
+    if (!regionName || regionSize == 0 || !mapRegion(regionName, regionSize, true, mappingHandle, data))
+        return false;
+
+    // Pagefile-backed mappings start zeroed, but a reused name may not be
+    std::memset(data, 0, regionSize);
+    size = regionSize;
+    owner = true;
+    std::snprintf(name, sizeof(name), "%s", regionName);
+    return true;
+}
+
+bool SharedMemoryRegion::open(const char* regionName, size_t regionSize)
+{
+    close();
+    if (!regionName || regionSize == 0 || !mapRegion(regionName, regionSize, false, mappingHandle, data))
+        return false;
+
+    size = regionSize;
+    owner = false;
+    std::snprintf(name, sizeof(name), "%s", regionName);
+    return true;
+}
+
+void SharedMemoryRegion::close()
+{
+    // Windows removes the name once the last handle is closed
+    if (data)
+        UnmapViewOfFile(data);
+    if (mappingHandle)
+        CloseHandle(static_cast<HANDLE>(mappingHandle));
+
+    data = nullptr;
+    size = 0;
+    owner = false;
+    name[0] = '\0';
+    mappingHandle = nullptr;
+}
+
+#else
+
+// POSIX shared memory names must start with a slash
+static void posixName(const char* name, char* out, size_t outSize)
+{
+    std::snprintf(out, outSize, "%s%s", name[0] == '/' ? "" : "/", name);
+}
+
+bool SharedMemoryRegion::create(const char* regionName, size_t regionSize)
+{
+    close();
+    if (!regionName || regionSize == 0)
+        return false;
+
+    char shmName[256];
+    posixName(regionName, shmName, sizeof(shmName));
+
+    shm_unlink(shmName); // Remove a region left behind by a crashed writer
+    int fd = shm_open(shmName, O_CREAT | O_EXCL | O_RDWR, 0644);
+    if (fd < 0)
+        return false;
+
+    if (ftruncate(fd, static_cast<off_t>(regionSize)) != 0)
+    {
+        ::close(fd);
+        shm_unlink(shmName);
+        return false;
+    }
+
+    void* view = mmap(nullptr, regionSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED)
+    {
+        shm_unlink(shmName);
+        return false;
+    }
+
+    data = view;
+    size = regionSize;
+    owner = true;
+    std::snprintf(name, sizeof(name), "%s", shmName);
+    return true;
+}
+
+bool SharedMemoryRegion::open(const char* regionName, size_t regionSize)
+{
+    close();
+    if (!regionName || regionSize == 0)
+        return false;
+
+    char shmName[256];
+    posixName(regionName, shmName, sizeof(shmName));
+
+    int fd = shm_open(shmName, O_RDWR, 0);
+    if (fd < 0)
+        return false;
+
+    void* view = mmap(nullptr, regionSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED)
+        return false;
+
+    data = view;
+    size = regionSize;
+    owner = false;
+    std::snprintf(name, sizeof(name), "%s", shmName);
+    return true;
+}
+
+void SharedMemoryRegion::close()
+{
+    if (data)
+        munmap(data, size);
+    if (owner)
+        shm_unlink(name);
+
+    data = nullptr;
+    size = 0;
+    owner = false;
+    name[0] = '\0';
+}
+
+#endif
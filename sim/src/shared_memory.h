@@ -0,0 +1,39 @@
+#ifndef SHARED_MEMORY_H
+
+#define SHARED_MEMORY_H
+
+#include <cstddef>
+
+// Named, writable shared memory region that other processes can attach to by
+// name (POSIX shm_open / Windows named file mapping). The creator owns the
+// name and removes it on close; readers keep their mapping until they detach.
+class SharedMemoryRegion
+{
+public:
+    SharedMemoryRegion();
+    ~SharedMemoryRegion();
+
+    SharedMemoryRegion(const SharedMemoryRegion&) = delete;
+    SharedMemoryRegion& operator=(const SharedMemoryRegion&) = delete;
+
+    // Create a zero-filled region, replacing any stale region with the same name
+    bool create(const char* name, size_t size);
+    // Attach to an existing region created by another process
+    bool open(const char* name, size_t size);
+    void close();
+
+    bool isOpen() const { return data != nullptr; }
+    void* getData() const { return data; }
+    size_t getSize() const { return size; }
+
+private:
+    void* data;
+    size_t size;
+    bool owner;
+    char name[256];
+#ifdef _WIN32
+    void* mappingHandle;
+#endif
+};
+
+#endif // SHARED_MEMORY_H
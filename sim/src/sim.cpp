@@ -2,29 +2,73 @@
 #include <algorithm>
 #include <chrono>
 #include <cmath>
+#include <cstddef>
+#include <cstring>
 #include <string>
 #include <vector>
 #include <iostream>
 #include <glm/glm.hpp>
 #include <glm/gtc/quaternion.hpp>
 #include "track.h"
+#include "track_set.h"
 #include "physics.h"
 #include "vehicle.h"
+#include "sim_context.h"
+#include "expert_driver.h"
+#include "jacobian.h"
+#include "mlp_policy.h"
+#include "observation.h"
+#include "philox.h"
+#include "rollout.h"
+#include "telemetry.h"
+#include "thread_pool.h"
+#include "vec_env.h"
+#ifndef RACEGYM_HEADLESS
 #include "renderer.h"
+#endif
+
+static_assert(SIM_VEHICLE_STATE_SIZE == VEHICLE_STATE_SIZE, "vehicle state layout mismatch");
+static_assert(SIM_VEHICLE_CONTROL_SIZE == VEHICLE_CONTROL_SIZE, "vehicle control layout mismatch");
+static_assert(SIM_OBSERVATION_SIZE == OBSERVATION_SIZE, "observation layout mismatch");
+static_assert(SIM_ACTION_SIZE == VEC_ENV_ACTION_SIZE, "action layout mismatch");
+static_assert(SIM_STATS_BUCKETS == EPISODE_STATS_BUCKETS, "histogram layout mismatch");
+static_assert(sizeof(SimStatSummary) == sizeof(StatSummary) &&
+              offsetof(SimStatSummary, buckets) == offsetof(StatSummary, buckets), "stat summary layout mismatch");
+static_assert(sizeof(SimEpisodeStats) == sizeof(EpisodeStats) &&
+              offsetof(SimEpisodeStats, lap_time) == offsetof(EpisodeStats, lapTime), "episode stats layout mismatch");
+
+// Window handling; headless builds leave out the renderer and GL entirely
+static bool initWindow() {
+#ifdef RACEGYM_HEADLESS
+    std::cerr << "racegym_sim was built headless (RACEGYM_HEADLESS); no window available" << std::endl;
+    return false;
+#else
+    return Renderer::init();
+#endif
+}
 
-namespace {
-
-struct SimContext {
-    bool windowed;
-    bool running;
-    PhysicsWorld physicsWorld;
-    Track* track;
-    std::vector<Vehicle*> vehicles;
+static bool hasWindow(const SimContext* ctx) {
+#ifdef RACEGYM_HEADLESS
+    (void)ctx;
+    return false;
+#else
+    return ctx->windowed && Renderer::is_initialized();
+#endif
+}
 
-    SimContext() : windowed(false), running(false), track(nullptr) {}
-};
+static void renderWindow(SimContext* ctx) {
+#ifdef RACEGYM_HEADLESS
+    (void)ctx;
+#else
+    Renderer::render_step(ctx->track, ctx->vehicles, ctx->running);
+#endif
+}
 
-}   // namespace
+static void shutdownWindow() {
+#ifndef RACEGYM_HEADLESS
+    Renderer::shutdown();
+#endif
+}
 
 extern "C" {
 
@@ -34,7 +78,7 @@ RACEGYM_API void* sim_init(int windowed) {
     ctx->running = true;
 
     if (ctx->windowed) {
-        if (!Renderer::init()) {
+        if (!initWindow()) {
             delete ctx;
             return nullptr;
         }
@@ -49,21 +93,22 @@ RACEGYM_API void sim_step(void* sim_context) {
     }
 
     SimContext* ctx = static_cast<SimContext*>(sim_context);
+    applyPolicies(&ctx, 1);
 
-    const float substepDelta = 1.0f / 100.0f;  // 0.01 seconds per physics step
-    const int maxSubsteps = 10;
+    const float substepDelta = SUBSTEP_DELTA;
+    const int maxSubsteps = SUBSTEPS_PER_STEP;
 
     auto startTime = std::chrono::high_resolution_clock::now();
     float simulatedTime = 0.0f;
     int substepsCompleted = 0;
     bool hasRendered = false;
 
-    bool hasWindow = ctx->windowed && Renderer::is_initialized();
+    bool windowOpen = hasWindow(ctx);
 
     while (substepsCompleted < maxSubsteps) {
         // Check if we should renderCtx or simulate
         bool shouldRender = false;
-        if (hasWindow && ctx->running) {
+        if (windowOpen && ctx->running) {
             auto currentTime = std::chrono::high_resolution_clock::now();
             std::chrono::duration<float> elapsed = currentTime - startTime;
             float elapsedSeconds = elapsed.count();
@@ -73,24 +118,23 @@ RACEGYM_API void sim_step(void* sim_context) {
         }
 
         if (shouldRender) {
-            Renderer::render_step(ctx->track, ctx->vehicles, ctx->running);
+            renderWindow(ctx);
             if (!ctx->running) return;
             hasRendered = true;
         } else {
             // Perform physics step
-            ctx->physicsWorld.stepSimulation(substepDelta);
-            for (auto vehicle : ctx->vehicles) {
-                vehicle->step(substepDelta);
-            }
+            ctx->substep(substepDelta);
             substepsCompleted++;
             simulatedTime += substepDelta;
         }
     }
 
     // Ensure at least one renderer if windowed and we somehow didn't render yet
-    if (hasWindow && ctx->running && !hasRendered) {
-        Renderer::render_step(ctx->track, ctx->vehicles, ctx->running);
+    if (windowOpen && ctx->running && !hasRendered) {
+        renderWindow(ctx);
     }
+
+    ctx->startStepResults();
 }
 
 RACEGYM_API void sim_shutdown(void* sim_context) {
@@ -102,12 +146,7 @@ RACEGYM_API void sim_shutdown(void* sim_context) {
     ctx->running = false;
 
     if (ctx->windowed) {
-        Renderer::shutdown();
-    }
-
-    if (ctx->track) {
-        delete ctx->track;
-        ctx->track = nullptr;
+        shutdownWindow();
     }
 
     delete ctx;
@@ -120,36 +159,113 @@ RACEGYM_API void sim_load_track(void* sim_context, const char* path) {
 
     SimContext* ctx = static_cast<SimContext*>(sim_context);
 
-    if(ctx->track) {
-        delete ctx->track;
-        for(auto vehicle : ctx->vehicles) {
-            delete vehicle;
-        }
-        ctx->vehicles.clear(); // Clear physics bodies to prevent dangling pointers
+    // Tracks already loaded in this process are shared rather than reloaded.
+    // Resolve before releasing the old view so reloading the same track is
+    // just a refcount increment.
+    std::shared_ptr<const TrackData> data = TrackData::loadShared(path);
+    if (!data) {
+        std::cerr << "Failed to load track: " << path << std::endl;
     }
 
-    ctx->track = new Track(path);
+    ctx->setTrack(data);
 }
 
-RACEGYM_API void* sim_add_vehicle(void* sim_context, float spawnT) {
-    if (!sim_context) {
+RACEGYM_API int sim_compile_track(const char* json_path, const char* out_path) {
+    if (!json_path || !out_path) {
+        return 1;
+    }
+
+    std::shared_ptr<const TrackData> data = TrackData::load(json_path);
+    if (!data) {
+        std::cerr << "Failed to load track: " << json_path << std::endl;
+        return 1;
+    }
+
+    return data->writeCompiled(out_path) ? 0 : 1;
+}
+
+RACEGYM_API int sim_check_compiled_track(const char* path) {
+    if (!path) {
+        return 1;
+    }
+
+    return TrackData::isCurrentCompiled(path) ? 0 : 1;
+}
+
+RACEGYM_API void* sim_load_track_set(const char* directory) {
+    if (!directory) {
+        return nullptr;
+    }
+
+    return TrackSet::loadDirectory(directory);
+}
+
+RACEGYM_API void sim_free_track_set(void* track_set) {
+    // Contexts keep their selected track alive on their own
+    delete static_cast<TrackSet*>(track_set);
+}
+
+RACEGYM_API int sim_get_track_set_size(void* track_set) {
+    if (!track_set) {
+        return 0;
+    }
+
+    return static_cast<TrackSet*>(track_set)->size();
+}
+
+RACEGYM_API const char* sim_get_track_set_name(void* track_set, int index) {
+    if (!track_set) {
         return nullptr;
     }
 
+    TrackSet* set = static_cast<TrackSet*>(track_set);
+    if (index < 0 || index >= set->size()) {
+        return nullptr;
+    }
+
+    return set->getName(index).c_str();
+}
+
+RACEGYM_API int sim_random_uniform(unsigned long long seed, unsigned int env, unsigned int episode,
+                                   unsigned int step, float* out, int count) {
+    if (!out || count < 0) {
+        return 1;
+    }
+    RandomStream(seed, env, episode, step).fillUniform(out, count);
+    return 0;
+}
+
+RACEGYM_API int sim_sample_track_set(void* track_set, unsigned long long seed, const float* weights) {
+    if (!track_set) {
+        return -1;
+    }
+
+    return static_cast<TrackSet*>(track_set)->sample(seed, weights);
+}
+
+RACEGYM_API int sim_select_track(void* sim_context, void* track_set, int index) {
+    if (!sim_context || !track_set) {
+        return 1;
+    }
+
     SimContext* ctx = static_cast<SimContext*>(sim_context);
+    TrackSet* set = static_cast<TrackSet*>(track_set);
+    if (index < 0 || index >= set->size()) {
+        return 1;
+    }
+
+    ctx->setTrack(set->get(index));
+    return 0;
+}
 
-    if(!ctx->track) {
-        std::cerr << "Cannot add vehicle: no track loaded." << std::endl;
+RACEGYM_API void* sim_add_vehicle(void* sim_context, float spawnT) {
+    if (!sim_context) {
         return nullptr;
     }
 
-    glm::vec2 startPos = ctx->track->getPosition(spawnT);
-    glm::vec2 startTangent = ctx->track->getTangent(spawnT);
-    float startAngle = atan2(startTangent.x, startTangent.y);    
+    SimContext* ctx = static_cast<SimContext*>(sim_context);
 
-    Vehicle *vehicle = new Vehicle(ctx->physicsWorld, glm::vec3(startPos.x, 0.75f, startPos.y), glm::vec3(0.0f, startAngle, 0.0f));
-    ctx->vehicles.push_back(vehicle);
-    return vehicle;
+    return ctx->addVehicle(spawnT);
 }
 
 RACEGYM_API void sim_remove_vehicle(void* sim_context, void* vehicle_ptr) {
@@ -158,13 +274,7 @@ RACEGYM_API void sim_remove_vehicle(void* sim_context, void* vehicle_ptr) {
     }
 
     SimContext* ctx = static_cast<SimContext*>(sim_context);
-    Vehicle* vehicle = static_cast<Vehicle*>(vehicle_ptr);
-
-    auto it = std::find(ctx->vehicles.begin(), ctx->vehicles.end(), vehicle);
-    if (it != ctx->vehicles.end()) {
-        ctx->vehicles.erase(it);
-        delete vehicle;
-    }
+    ctx->removeVehicle(static_cast<Vehicle*>(vehicle_ptr));
 }
 
 RACEGYM_API void sim_set_vehicle_control(void* vehicle_ptr, float steer, float throttle, float brake) {
@@ -188,11 +298,18 @@ RACEGYM_API float sim_get_vehicle_track_position(void* sim_context, void* vehicl
         return 0.0f;
     }
 
+    // Kept current every substep by updateTrackProgress
     Vehicle* vehicle = static_cast<Vehicle*>(vehicle_ptr);
-    glm::vec3 vehiclePos = vehicle->body->position;
-    glm::vec2 vehiclePos2D(vehiclePos.x, vehiclePos.z);
+    return vehicle->trackT;
+}
 
-    return ctx->track->getClosestT(vehiclePos2D);
+RACEGYM_API float sim_get_vehicle_progress(void* vehicle_ptr) {
+    if (!vehicle_ptr) {
+        return 0.0f;
+    }
+
+    Vehicle* vehicle = static_cast<Vehicle*>(vehicle_ptr);
+    return static_cast<float>(vehicle->trackProgress);
 }
 
 RACEGYM_API int sim_get_track_length(void* sim_context) {
@@ -216,6 +333,9 @@ RACEGYM_API int sim_is_vehicle_off_track(void* sim_context, void* vehicle_ptr) {
     SimContext* ctx = static_cast<SimContext*>(sim_context);
     Vehicle* vehicle = static_cast<Vehicle*>(vehicle_ptr);
 
+    if (const StepResult* result = ctx->getStepResult(vehicle)) {
+        return result->offTrack ? 1 : 0;
+    }
     return vehicle->isOffTrack(ctx->track) ? 1 : 0;
 }
 
@@ -230,35 +350,12 @@ RACEGYM_API int sim_get_observation(void* sim_context, void* vehicle_ptr, float*
         return 0;
     }
 
-    // Current track parameter
-    glm::vec3 vehiclePos = vehicle->body->position;
-    float currentT = ctx->track->getClosestT(glm::vec2(vehiclePos.x, vehiclePos.z));
-
-    // Generate waypoints (20 pairs => 40 points)
-    const int numWaypoints = 20;
-    const float waypointSpacing = 0.1f;
-    std::vector<glm::vec3> waypoints = ctx->track->getWaypoints(currentT, numWaypoints, waypointSpacing);
-
-    // Vehicle frame
-    glm::vec3 forward = glm::normalize(vehicle->body->orientation * glm::vec3(0.0f, 0.0f, 1.0f));
-    glm::vec3 right   = glm::normalize(vehicle->body->orientation * glm::vec3(1.0f, 0.0f, 0.0f));
-
-    int idx = 0;
-    for (const auto& wp : waypoints) {
-        if (idx + 2 > max_floats) break;
-        glm::vec3 rel = wp - vehiclePos;
-        out_buffer[idx++] = glm::dot(rel, right);    // local x (lateral)
-        out_buffer[idx++] = glm::dot(rel, forward);  // local z (longitudinal)
-    }
-
-    if (idx + 3 <= max_floats) {
-        glm::vec3 vel = vehicle->body->velocity;
-        out_buffer[idx++] = glm::dot(vel, forward); // longitudinal velocity
-        out_buffer[idx++] = glm::dot(vel, right);   // lateral velocity
-        out_buffer[idx++] = vehicle->body->angularVelocity.y; // yaw rate
+    const StepResult* result = max_floats >= OBSERVATION_SIZE ? ctx->getStepResult(vehicle) : nullptr;
+    if (result) {
+        std::memcpy(out_buffer, result->observation, sizeof(result->observation));
+        return OBSERVATION_SIZE;
     }
-
-    return idx;
+    return computeObservation(*ctx->track, *vehicle, out_buffer, max_floats);
 }
 
 RACEGYM_API void sim_get_vehicle_velocity(void* vehicle_ptr, float* out_vel_xyz) {
@@ -273,6 +370,409 @@ RACEGYM_API void sim_get_vehicle_velocity(void* vehicle_ptr, float* out_vel_xyz)
     out_vel_xyz[2] = vel.z;
 }
 
+RACEGYM_API int sim_get_vehicle_count(void* sim_context) {
+    if (!sim_context) {
+        return 0;
+    }
+
+    SimContext* ctx = static_cast<SimContext*>(sim_context);
+    return static_cast<int>(ctx->vehicles.size());
+}
+
+RACEGYM_API int sim_get_vehicle_states(void* sim_context, int fields_mask,
+                                       float* out_positions, float* out_orientations,
+                                       float* out_linear_velocities, float* out_angular_velocities,
+                                       float* out_wheel_spins, float* out_controls, int max_vehicles) {
+    if (!sim_context) {
+        return 0;
+    }
+
+    SimContext* ctx = static_cast<SimContext*>(sim_context);
+
+    // Drop fields the caller asked for but gave no buffer for
+    if (!out_positions) fields_mask &= ~SIM_STATE_POSITION;
+    if (!out_orientations) fields_mask &= ~SIM_STATE_ORIENTATION;
+    if (!out_linear_velocities) fields_mask &= ~SIM_STATE_LINEAR_VELOCITY;
+    if (!out_angular_velocities) fields_mask &= ~SIM_STATE_ANGULAR_VELOCITY;
+    if (!out_wheel_spins) fields_mask &= ~SIM_STATE_WHEEL_SPIN;
+    if (!out_controls) fields_mask &= ~SIM_STATE_CONTROLS;
+
+    int count = static_cast<int>(ctx->vehicles.size());
+    int written = std::max(0, std::min(count, max_vehicles));
+    for (int i = 0; i < written; ++i) {
+        const Vehicle* vehicle = ctx->vehicles[i];
+        const PhysicsBody* body = vehicle->body;
+
+        if (fields_mask & SIM_STATE_POSITION) {
+            float* out = out_positions + i * 3;
+            out[0] = body->position.x;
+            out[1] = body->position.y;
+            out[2] = body->position.z;
+        }
+        if (fields_mask & SIM_STATE_ORIENTATION) {
+            float* out = out_orientations + i * 4;
+            out[0] = body->orientation.w;
+            out[1] = body->orientation.x;
+            out[2] = body->orientation.y;
+            out[3] = body->orientation.z;
+        }
+        if (fields_mask & SIM_STATE_LINEAR_VELOCITY) {
+            float* out = out_linear_velocities + i * 3;
+            out[0] = body->velocity.x;
+            out[1] = body->velocity.y;
+            out[2] = body->velocity.z;
+        }
+        if (fields_mask & SIM_STATE_ANGULAR_VELOCITY) {
+            float* out = out_angular_velocities + i * 3;
+            out[0] = body->angularVelocity.x;
+            out[1] = body->angularVelocity.y;
+            out[2] = body->angularVelocity.z;
+        }
+        if (fields_mask & SIM_STATE_WHEEL_SPIN) {
+            float* out = out_wheel_spins + i * 4;
+            for (int w = 0; w < 4; ++w) {
+                out[w] = vehicle->getWheelAngularVelocity(w);
+            }
+        }
+        if (fields_mask & SIM_STATE_CONTROLS) {
+            float* out = out_controls + i * 3;
+            out[0] = vehicle->getSteerAmount();
+            out[1] = vehicle->getThrottle();
+            out[2] = vehicle->getBrake();
+        }
+    }
+
+    return count;
+}
+
+RACEGYM_API int sim_set_pipelined(void* sim_context, int enabled) {
+    if (!sim_context) {
+        return 1;
+    }
+
+    static_cast<SimContext*>(sim_context)->setPipelined(enabled != 0);
+    return 0;
+}
+
+RACEGYM_API int sim_enable_telemetry(void* sim_context, const char* name, int capacity) {
+    if (!sim_context || !name || capacity <= 0) {
+        return 1;
+    }
+
+    SimContext* ctx = static_cast<SimContext*>(sim_context);
+
+    TelemetryWriter* telemetry = TelemetryWriter::create(name, capacity);
+    if (!telemetry) {
+        std::cerr << "Failed to create telemetry buffer: " << name << std::endl;
+        return 1;
+    }
+
+    delete ctx->telemetry;
+    ctx->telemetry = telemetry;
+
+    return 0;
+}
+
+RACEGYM_API void sim_disable_telemetry(void* sim_context) {
+    if (!sim_context) {
+        return;
+    }
+
+    SimContext* ctx = static_cast<SimContext*>(sim_context);
+    delete ctx->telemetry;
+    ctx->telemetry = nullptr;
+}
+
+RACEGYM_API void sim_attach_expert_driver(void* vehicle, const SimExpertDriverParams* params) {
+    if (!vehicle) {
+        return;
+    }
+
+    ExpertDriverParams driverParams = DEFAULT_EXPERT_DRIVER_PARAMS;
+    if (params) {
+        driverParams.lookaheadBase = params->lookahead_base;
+        driverParams.lookaheadGain = params->lookahead_gain;
+        driverParams.maxSpeed = params->max_speed;
+        driverParams.maxLateralAccel = params->max_lateral_accel;
+        driverParams.maxBrakeDecel = params->max_brake_decel;
+        driverParams.speedGain = params->speed_gain;
+    }
+
+    Vehicle* v = static_cast<Vehicle*>(vehicle);
+    v->driver.reset(new ExpertDriver(driverParams));
+}
+
+RACEGYM_API void sim_detach_expert_driver(void* vehicle) {
+    if (!vehicle) {
+        return;
+    }
+
+    Vehicle* v = static_cast<Vehicle*>(vehicle);
+    v->driver.reset();
+}
+
+RACEGYM_API void* sim_load_policy(const char* path) {
+    std::shared_ptr<const MlpPolicy> policy = MlpPolicy::load(path);
+    if (!policy) {
+        return nullptr;
+    }
+
+    // The handle owns one reference; vehicles hold their own
+    return new std::shared_ptr<const MlpPolicy>(policy);
+}
+
+RACEGYM_API void sim_free_policy(void* policy) {
+    delete static_cast<std::shared_ptr<const MlpPolicy>*>(policy);
+}
+
+RACEGYM_API int sim_policy_forward(void* policy, const float* inputs, int batch, float* out_outputs) {
+    if (!policy || !inputs || !out_outputs || batch <= 0) {
+        return 0;
+    }
+
+    const MlpPolicy& mlp = **static_cast<std::shared_ptr<const MlpPolicy>*>(policy);
+    mlp.forward(inputs, batch, out_outputs);
+    return mlp.getOutputSize();
+}
+
+RACEGYM_API int sim_attach_policy(void* vehicle, void* policy) {
+    if (!vehicle || !policy) {
+        return 1;
+    }
+
+    const std::shared_ptr<const MlpPolicy>& mlp = *static_cast<std::shared_ptr<const MlpPolicy>*>(policy);
+    if (mlp->getInputSize() != OBSERVATION_SIZE || mlp->getOutputSize() < 2 || mlp->getOutputSize() > 3) {
+        std::cerr << "Policy shape " << mlp->getInputSize() << " -> " << mlp->getOutputSize()
+                  << " does not match the observation and action sizes" << std::endl;
+        return 1;
+    }
+
+    static_cast<Vehicle*>(vehicle)->policy = mlp;
+    return 0;
+}
+
+RACEGYM_API void sim_detach_policy(void* vehicle) {
+    if (!vehicle) {
+        return;
+    }
+
+    static_cast<Vehicle*>(vehicle)->policy.reset();
+}
+
+RACEGYM_API void sim_get_vehicle_state(void* vehicle, float* out_state) {
+    if (!vehicle || !out_state) {
+        return;
+    }
+
+    static_cast<Vehicle*>(vehicle)->getState(out_state);
+}
+
+RACEGYM_API void sim_set_vehicle_state(void* sim_context, void* vehicle, const float* state) {
+    if (!sim_context || !vehicle || !state) {
+        return;
+    }
+
+    SimContext* ctx = static_cast<SimContext*>(sim_context);
+    Vehicle* v = static_cast<Vehicle*>(vehicle);
+    ctx->discardStepResults();
+    v->setState(state);
+    v->resetTrackProgress(ctx->track);
+}
+
+RACEGYM_API void sim_step_batch(void** sim_contexts, int count) {
+    if (!sim_contexts || count <= 0) {
+        return;
+    }
+
+    std::vector<SimContext*> contexts;
+    contexts.reserve(count);
+    for (int i = 0; i < count; i++) {
+        if (sim_contexts[i]) {
+            contexts.push_back(static_cast<SimContext*>(sim_contexts[i]));
+        }
+    }
+
+    stepContextBatch(contexts.data(), (int)contexts.size());
+}
+
+RACEGYM_API int sim_compute_vehicle_jacobian(void* sim_context, const float* state, const float* control,
+                                             float epsilon, float* out_next_state,
+                                             float* out_state_jacobian, float* out_control_jacobian) {
+    if (!sim_context) {
+        return 1;
+    }
+
+    SimContext* ctx = static_cast<SimContext*>(sim_context);
+    bool ok = computeVehicleJacobian(*ctx, state, control, epsilon,
+                                     out_next_state, out_state_jacobian, out_control_jacobian);
+    return ok ? 0 : 1;
+}
+
+RACEGYM_API int sim_compute_vehicle_jacobian_exact(const float* state, const float* control,
+                                                   float* out_next_state, float* out_state_jacobian,
+                                                   float* out_control_jacobian) {
+    bool ok = computeVehicleJacobianExact(state, control,
+                                          out_next_state, out_state_jacobian, out_control_jacobian);
+    return ok ? 0 : 1;
+}
+
+RACEGYM_API int sim_rollout_batch(void* sim_context, void* vehicle, const float* state, const float* actions,
+                                  int num_candidates, int horizon, const SimRolloutCost* cost,
+                                  float* out_costs, float* out_final_states) {
+    if (!sim_context || !state || !actions || !out_costs || num_candidates <= 0 || horizon <= 0) {
+        return 1;
+    }
+
+    SimContext* ctx = static_cast<SimContext*>(sim_context);
+    if (!ctx->track) {
+        return 1;
+    }
+
+    RolloutCost rolloutCost = DEFAULT_ROLLOUT_COST;
+    if (cost) {
+        rolloutCost.progressWeight = cost->progress_weight;
+        rolloutCost.offTrackPenalty = cost->off_track_penalty;
+        rolloutCost.crashPenalty = cost->crash_penalty;
+        rolloutCost.controlRateWeight = cost->control_rate_weight;
+    }
+
+    rolloutBatch(ctx->track, static_cast<const Vehicle*>(vehicle), state, actions, num_candidates, horizon, rolloutCost, out_costs, out_final_states);
+    return 0;
+}
+
+RACEGYM_API void* sim_vec_env_create(void* track_set, int num_envs, int fixed_start, int max_episode_steps) {
+    if (!track_set || num_envs <= 0 || max_episode_steps <= 0) {
+        return nullptr;
+    }
+
+    return new VecEnv(static_cast<TrackSet*>(track_set), num_envs, fixed_start != 0, max_episode_steps);
+}
+
+RACEGYM_API void sim_vec_env_free(void* vec_env) {
+    delete static_cast<VecEnv*>(vec_env);
+}
+
+RACEGYM_API int sim_vec_env_set_buffers(void* vec_env, const float* actions, float* observations, float* rewards,
+                                        unsigned char* terminated, unsigned char* truncated, float* lap_times,
+                                        float* terminal_observations) {
+    if (!vec_env || !actions || !observations || !rewards || !terminated || !truncated || !lap_times) {
+        return 1;
+    }
+
+    VecEnvBuffers buffers;
+    buffers.actions = actions;
+    buffers.observations = observations;
+    buffers.rewards = rewards;
+    buffers.terminated = terminated;
+    buffers.truncated = truncated;
+    buffers.lapTimes = lap_times;
+    buffers.terminalObservations = terminal_observations;
+    static_cast<VecEnv*>(vec_env)->setBuffers(buffers);
+    return 0;
+}
+
+RACEGYM_API void sim_vec_env_reset(void* vec_env, unsigned long long seed) {
+    if (!vec_env) {
+        return;
+    }
+
+    static_cast<VecEnv*>(vec_env)->reset(seed);
+}
+
+RACEGYM_API int sim_vec_env_set_autoreset(void* vec_env, int enabled) {
+    if (!vec_env) {
+        return 1;
+    }
+
+    static_cast<VecEnv*>(vec_env)->setAutoReset(enabled != 0);
+    return 0;
+}
+
+RACEGYM_API int sim_vec_env_set_fault_reset(void* vec_env, int enabled) {
+    if (!vec_env) {
+        return 1;
+    }
+
+    static_cast<VecEnv*>(vec_env)->setFaultReset(enabled != 0);
+    return 0;
+}
+
+RACEGYM_API int sim_vec_env_reset_finished(void* vec_env) {
+    if (!vec_env) {
+        return 0;
+    }
+
+    return static_cast<VecEnv*>(vec_env)->resetFinished();
+}
+
+RACEGYM_API int sim_vec_env_get_active_count(void* vec_env) {
+    if (!vec_env) {
+        return 0;
+    }
+
+    return static_cast<VecEnv*>(vec_env)->getActiveCount();
+}
+
+RACEGYM_API int sim_vec_env_get_faulted(void* vec_env, int* out_indices, int max_count) {
+    if (!vec_env) {
+        return 0;
+    }
+
+    const std::vector<int>& faulted = static_cast<VecEnv*>(vec_env)->getFaultedEnvs();
+    if (out_indices) {
+        std::copy_n(faulted.begin(), std::min(static_cast<int>(faulted.size()), std::max(max_count, 0)), out_indices);
+    }
+    return static_cast<int>(faulted.size());
+}
+
+RACEGYM_API int sim_pin_worker_threads(void) {
+    return ThreadPool::global().pinWorkers() ? 0 : 1;
+}
+
+RACEGYM_API void sim_vec_env_step_batch(void** vec_envs, int count) {
+    if (!vec_envs || count <= 0) {
+        return;
+    }
+
+    std::vector<VecEnv*> batches;
+    batches.reserve(count);
+    for (int i = 0; i < count; i++) {
+        if (vec_envs[i]) {
+            batches.push_back(static_cast<VecEnv*>(vec_envs[i]));
+        }
+    }
+
+    VecEnv::stepBatch(batches.data(), (int)batches.size());
+}
+
+RACEGYM_API int sim_vec_env_get_stats(void* vec_env, SimEpisodeStats* out_stats, int reset) {
+    if (!vec_env || !out_stats) {
+        return 1;
+    }
+
+    VecEnv* batch = static_cast<VecEnv*>(vec_env);
+    std::memcpy(out_stats, &batch->getStats(), sizeof(SimEpisodeStats));
+    if (reset) {
+        batch->clearStats();
+    }
+    return 0;
+}
+
+RACEGYM_API int sim_vec_env_set_stats_range(void* vec_env, int metric, float histogram_min, float histogram_max) {
+    if (!vec_env) {
+        return 1;
+    }
+
+    EpisodeStats& stats = static_cast<VecEnv*>(vec_env)->getStats();
+    switch (metric) {
+        case SIM_STAT_EPISODE_RETURN: stats.episodeReturn.setRange(histogram_min, histogram_max); return 0;
+        case SIM_STAT_EPISODE_LENGTH: stats.episodeLength.setRange(histogram_min, histogram_max); return 0;
+        case SIM_STAT_EPISODE_DISTANCE: stats.episodeDistance.setRange(histogram_min, histogram_max); return 0;
+        case SIM_STAT_LAP_TIME: stats.lapTime.setRange(histogram_min, histogram_max); return 0;
+        default: return 1;
+    }
+}
+
 RACEGYM_API void sim_get_track_normal(void* sim_context, float t, float* out_normal_xy) {
     if (!sim_context || !out_normal_xy) {
         return;
@@ -297,39 +797,11 @@ RACEGYM_API int sim_is_vehicle_crashed(void* sim_context, void* vehicle_ptr) {
 
     SimContext* ctx = static_cast<SimContext*>(sim_context);
     Vehicle* vehicle = static_cast<Vehicle*>(vehicle_ptr);
-    
-    glm::vec3 pos = vehicle->body->position;
-    glm::quat orientation = vehicle->body->orientation;
-    
-    // Check if underground (y < -2.0)
-    if (pos.y < -2.0f) {
-        return 1;
-    }
-    
-    // Check if too high in the air (y > 20.0)
-    if (pos.y > 20.0f) {
-        return 1;
-    }
-    
-    // Check if upside down - get the up vector in world space
-    glm::vec3 up = orientation * glm::vec3(0.0f, 1.0f, 0.0f);
-    // If the dot product with world up is negative, vehicle is upside down
-    if (up.y < -0.1f) {
-        return 1;
-    }
-    
-    // Check if too far from track (horizontal distance > 100 units)
-    if (ctx->track) {
-        glm::vec2 vehiclePos2D = glm::vec2(pos.x, pos.z);
-        float t = ctx->track->getClosestT(vehiclePos2D);
-        glm::vec2 trackPos = ctx->track->getPosition(t);
-        float distanceFromTrack = glm::distance(vehiclePos2D, trackPos);
-        if (distanceFromTrack > 100.0f) {
-            return 1;
-        }
+
+    if (const StepResult* result = ctx->getStepResult(vehicle)) {
+        return result->crashed ? 1 : 0;
     }
-    
-    return 0;
+    return isCrashed(vehicle->body->position, vehicle->body->orientation, ctx->track) ? 1 : 0;
 }
 
 } // extern "C"
\ No newline at end of file
@@ -2,8 +2,12 @@
 #define RACEGYM_SIM_H
 
 #ifdef _WIN32
+#ifdef racegym_sim_EXPORTS
 #define RACEGYM_API __declspec(dllexport)
 #else
+#define RACEGYM_API __declspec(dllimport)
+#endif
+#else
 #define RACEGYM_API
 #endif
 
@@ -11,6 +15,88 @@
 extern "C" {
 #endif
 
+/* Field selection bits for sim_get_vehicle_states */
+#define SIM_STATE_POSITION         (1 << 0)  /* 3 floats per vehicle: x, y, z (world) */
+#define SIM_STATE_ORIENTATION      (1 << 1)  /* 4 floats per vehicle: w, x, y, z quaternion */
+#define SIM_STATE_LINEAR_VELOCITY  (1 << 2)  /* 3 floats per vehicle: x, y, z (world) */
+#define SIM_STATE_ANGULAR_VELOCITY (1 << 3)  /* 3 floats per vehicle: x, y, z (world) */
+#define SIM_STATE_WHEEL_SPIN       (1 << 4)  /* 4 floats per vehicle: FR, FL, RR, RL angular velocity in rad/s */
+#define SIM_STATE_CONTROLS         (1 << 5)  /* 3 floats per vehicle: steer, throttle, brake */
+
+/*
+ * Full dynamic state of one vehicle, as used by sim_get_vehicle_state, sim_set_vehicle_state
+ * and sim_compute_vehicle_jacobian:
+ * position x, y, z | orientation w, x, y, z | linear velocity x, y, z | angular velocity x, y, z |
+ * suspension compression FR, FL, RR, RL | wheel angular velocity FR, FL, RR, RL |
+ * pending chassis force x, y, z | pending chassis torque x, y, z
+ */
+#define SIM_VEHICLE_STATE_SIZE   27
+#define SIM_VEHICLE_CONTROL_SIZE 3   /* steer, throttle, brake */
+
+#define SIM_OBSERVATION_SIZE 83  /* See sim_get_observation */
+#define SIM_ACTION_SIZE 2        /* Gym action of sim_vec_env_*: steer, throttle (negative values brake) */
+
+#define SIM_STEP_SECONDS 0.1f  /* Simulated time advanced by one sim_step */
+
+/* Tuning of the built-in expert driver, see sim_attach_expert_driver */
+typedef struct SimExpertDriverParams {
+    float lookahead_base;     /* Pure-pursuit lookahead at standstill, metres */
+    float lookahead_gain;     /* Extra lookahead per m/s of speed, seconds */
+    float max_speed;          /* Straight-line target speed, m/s */
+    float max_lateral_accel;  /* Cornering grip budget, m/s^2 */
+    float max_brake_decel;    /* Braking budget for upcoming corners, m/s^2 */
+    float speed_gain;         /* Throttle/brake per m/s of speed error */
+} SimExpertDriverParams;
+
+/*
+ * Cost accumulated by sim_rollout_batch. Each step costs
+ * -progress_weight * (track segments advanced) + control_rate_weight * |u_t - u_{t-1}|^2,
+ * with u the controls after clamping to their valid ranges.
+ * Going off track or crashing adds the matching penalty once and ends that candidate's rollout.
+ */
+typedef struct SimRolloutCost {
+    float progress_weight;
+    float off_track_penalty;
+    float crash_penalty;
+    float control_rate_weight;
+} SimRolloutCost;
+
+/* Native episode statistics of a sim_vec_env batch, see sim_vec_env_get_stats */
+#define SIM_STATS_BUCKETS 32
+
+#define SIM_STAT_EPISODE_RETURN   0
+#define SIM_STAT_EPISODE_LENGTH   1
+#define SIM_STAT_EPISODE_DISTANCE 2  /* Track segments covered */
+#define SIM_STAT_LAP_TIME         3  /* Seconds, every completed lap */
+
+/*
+ * Moments, extremes and a histogram of one metric. Bucket i counts values in
+ * [histogram_min + i * width, histogram_min + (i + 1) * width); values outside the range
+ * are counted in the first or last bucket.
+ */
+typedef struct SimStatSummary {
+    unsigned long long count;
+    double sum;
+    double sum_squared;
+    float min;
+    float max;
+    float histogram_min;
+    float histogram_max;
+    unsigned long long buckets[SIM_STATS_BUCKETS];
+} SimStatSummary;
+
+typedef struct SimEpisodeStats {
+    unsigned long long steps;       /* Env steps taken */
+    unsigned long long episodes;    /* Episodes finished */
+    unsigned long long terminated;  /* ... by going off track or crashing */
+    unsigned long long truncated;   /* ... by hitting max_episode_steps */
+    unsigned long long faulted;     /* Episodes cut off because the physics state diverged */
+    SimStatSummary episode_return;
+    SimStatSummary episode_length;
+    SimStatSummary episode_distance;
+    SimStatSummary lap_time;
+} SimEpisodeStats;
+
 /**
  * Initialize a new simulation instance.
  * 
@@ -35,14 +121,107 @@ RACEGYM_API void sim_step(void* sim_context);
 RACEGYM_API void sim_shutdown(void* sim_context);
 
 /**
- * Load a track from a JSON file into the simulation.
+ * Load a track into the simulation.
+ * Accepts either a JSON track or a compiled track written by sim_compile_track. Compiled
+ * tracks are memory-mapped read-only, so every process loading the same file shares one copy.
  * 
  * @param sim_context Pointer to simulation context returned by sim_init
- * @param path Path to the JSON file containing track data
- * @return 0 on success, non-zero on failure
+ * @param path Path to the JSON or compiled track file
  */
 RACEGYM_API void sim_load_track(void* sim_context, const char* path);
 
+/**
+ * Compile a JSON track, together with its precomputed tables, into a binary file
+ * that sim_load_track can map directly.
+ * 
+ * @param json_path Path to the JSON file containing track data
+ * @param out_path Path of the compiled track file to write
+ * @return 0 on success, non-zero on failure
+ */
+RACEGYM_API int sim_compile_track(const char* json_path, const char* out_path);
+
+/**
+ * Check that a file is a compiled track this library can load, i.e. one written by
+ * sim_compile_track of the same format version and not truncated. Callers caching
+ * compiled tracks use this to rebuild files left behind by another version.
+ * 
+ * @param path Path of the compiled track file
+ * @return 0 if the file is a loadable compiled track, non-zero otherwise
+ */
+RACEGYM_API int sim_check_compiled_track(const char* path);
+
+/**
+ * Load every track in a directory (*.json, or compiled *.rgt which take precedence) into
+ * a track set. Tracks load in parallel and are shared with any context that selects them;
+ * compiled tracks are memory-mapped, so the set is also shared across processes.
+ * 
+ * @param directory Path to the directory containing the tracks
+ * @return Opaque pointer to the track set, or nullptr if the directory holds no track or
+ *         any of them fails to load (each failure is reported on stderr)
+ */
+RACEGYM_API void* sim_load_track_set(const char* directory);
+
+/**
+ * Free a track set. Contexts that selected a track from it keep that track alive.
+ * 
+ * @param track_set Pointer returned by sim_load_track_set
+ */
+RACEGYM_API void sim_free_track_set(void* track_set);
+
+/**
+ * Get the number of tracks in a track set. Tracks are indexed in file name order.
+ * 
+ * @param track_set Pointer returned by sim_load_track_set
+ * @return Number of tracks
+ */
+RACEGYM_API int sim_get_track_set_size(void* track_set);
+
+/**
+ * Get the name of a track in a track set (its file name without extension).
+ * 
+ * @param track_set Pointer returned by sim_load_track_set
+ * @param index Track index in [0, sim_get_track_set_size)
+ * @return Name owned by the track set, or nullptr if the index is invalid
+ */
+RACEGYM_API const char* sim_get_track_set_name(void* track_set, int index);
+
+/**
+ * Fill out with uniform [0, 1) floats from the counter-based random stream keyed by
+ * (seed, env, episode, step). The same arguments always give the same values, whatever
+ * thread asks and in any order, and distinct keys give independent streams.
+ * 
+ * @param seed Run seed
+ * @param env Environment index
+ * @param episode Episode number within the environment
+ * @param step Step within the episode
+ * @param out Output array of count floats
+ * @param count Number of values to draw
+ * @return 0 on success, non-zero if out is null or count is negative
+ */
+RACEGYM_API int sim_random_uniform(unsigned long long seed, unsigned int env, unsigned int episode,
+                                   unsigned int step, float* out, int count);
+
+/**
+ * Deterministically pick a track index from a seed.
+ * 
+ * @param track_set Pointer returned by sim_load_track_set
+ * @param seed Seed for this selection (e.g. drawn from the env's RNG on reset)
+ * @param weights Optional per-track non-negative weights (sim_get_track_set_size values), or nullptr for uniform
+ * @return Selected index, or -1 if track_set is null
+ */
+RACEGYM_API int sim_sample_track_set(void* track_set, unsigned long long seed, const float* weights);
+
+/**
+ * Switch the context to a track from a track set. This only swaps a shared pointer;
+ * like sim_load_track, all vehicles are removed.
+ * 
+ * @param sim_context Pointer to simulation context returned by sim_init
+ * @param track_set Pointer returned by sim_load_track_set
+ * @param index Track index in [0, sim_get_track_set_size)
+ * @return 0 on success, non-zero on failure
+ */
+RACEGYM_API int sim_select_track(void* sim_context, void* track_set, int index);
+
 /**
  * Add a vehicle to the simulation at the default starting position.
  * 
@@ -77,6 +256,16 @@ RACEGYM_API void sim_set_vehicle_control(void* vehicle, float steer, float throt
  */
 RACEGYM_API float sim_get_vehicle_track_position(void* sim_context, void* vehicle_ptr);
 
+/**
+ * Get the vehicle's unwrapped progress along the track.
+ * Starts at the spawn position and accumulates every physics substep without wrapping,
+ * so reward is simply the difference between two calls.
+ * 
+ * @param vehicle_ptr Pointer to the vehicle
+ * @return Distance along the track in segments (one lap = sim_get_track_length)
+ */
+RACEGYM_API float sim_get_vehicle_progress(void* vehicle_ptr);
+
 /**
  * Get the length of the track in segments.
  * 
@@ -115,6 +304,364 @@ RACEGYM_API int sim_get_observation(void* sim_context, void* vehicle_ptr, float*
  */
 RACEGYM_API void sim_get_vehicle_velocity(void* vehicle_ptr, float* out_vel_xyz);
 
+/**
+ * Get the number of vehicles in the simulation.
+ * 
+ * @param sim_context Pointer to simulation context
+ * @return Number of vehicles; vehicles are ordered by when they were added
+ */
+RACEGYM_API int sim_get_vehicle_count(void* sim_context);
+
+/**
+ * Copy the state of every vehicle into caller-allocated arrays, one array per field,
+ * in a single pass. Each array holds max_vehicles entries of the field's width (see the
+ * SIM_STATE_* bits), in vehicle order; vehicles beyond max_vehicles are not written.
+ * Arrays for fields not selected in fields_mask may be null.
+ * 
+ * @param sim_context Pointer to simulation context
+ * @param fields_mask Bitwise OR of SIM_STATE_* values
+ * @param out_positions Output for SIM_STATE_POSITION
+ * @param out_orientations Output for SIM_STATE_ORIENTATION
+ * @param out_linear_velocities Output for SIM_STATE_LINEAR_VELOCITY
+ * @param out_angular_velocities Output for SIM_STATE_ANGULAR_VELOCITY
+ * @param out_wheel_spins Output for SIM_STATE_WHEEL_SPIN
+ * @param out_controls Output for SIM_STATE_CONTROLS
+ * @param max_vehicles Capacity of each array, in vehicles
+ * @return Number of vehicles in the context, which may exceed max_vehicles
+ */
+RACEGYM_API int sim_get_vehicle_states(void* sim_context, int fields_mask,
+                                       float* out_positions, float* out_orientations,
+                                       float* out_linear_velocities, float* out_angular_velocities,
+                                       float* out_wheel_spins, float* out_controls, int max_vehicles);
+
+/**
+ * Turn pipelined stepping on or off. When on, sim_step and sim_step_batch return as soon as
+ * the physics is done, and a worker thread computes every vehicle's observation and
+ * off-track/crash flags in the background. sim_get_observation, sim_is_vehicle_off_track
+ * and sim_is_vehicle_crashed wait for it, so work done between the step and those queries
+ * (e.g. policy inference for other environments) hides their cost. Setting controls never
+ * waits; calls that change vehicle state or the track wait first. Results are identical
+ * to the non-pipelined mode.
+ *
+ * @param sim_context Pointer to simulation context
+ * @param enabled Non-zero to enable
+ * @return 0 on success, non-zero on failure
+ */
+RACEGYM_API int sim_set_pipelined(void* sim_context, int enabled);
+
+/**
+ * Start streaming per-substep vehicle telemetry into a ring buffer in named shared memory.
+ * A viewer in another process attaches by name (see racegym/telemetry.py) and reads
+ * without ever blocking the simulation; if it falls behind, the oldest records are dropped.
+ * Replaces any buffer previously enabled on this context.
+ * 
+ * @param sim_context Pointer to simulation context
+ * @param name Shared memory name
+ * @param capacity Number of records the ring holds
+ * @return 0 on success, non-zero on failure
+ */
+RACEGYM_API int sim_enable_telemetry(void* sim_context, const char* name, int capacity);
+
+/**
+ * Stop streaming telemetry and release the shared memory buffer.
+ * 
+ * @param sim_context Pointer to simulation context
+ */
+RACEGYM_API void sim_disable_telemetry(void* sim_context);
+
+/**
+ * Hand a vehicle's controls to the built-in expert driver. Before every physics substep
+ * the driver steers by pure pursuit along the track centreline and picks a target speed
+ * from the curvature ahead, so traffic and demonstrations run without a Python control
+ * loop. The chosen controls can be read back with sim_get_vehicle_states.
+ * Replaces any driver already attached; sim_set_vehicle_control has no lasting effect
+ * while a driver is attached.
+ * 
+ * @param vehicle Pointer to the vehicle
+ * @param params Driver tuning, or null for the defaults {6, 0.3, 40, 8, 6, 0.5}
+ */
+RACEGYM_API void sim_attach_expert_driver(void* vehicle, const SimExpertDriverParams* params);
+
+/**
+ * Return a vehicle's controls to the caller. The last controls the driver chose stay applied.
+ * 
+ * @param vehicle Pointer to the vehicle
+ */
+RACEGYM_API void sim_detach_expert_driver(void* vehicle);
+
+/**
+ * Load a dense MLP policy exported with racegym/policy_export.py.
+ * 
+ * @param path Path to the .rgmp weight file
+ * @return Opaque policy handle, or nullptr on failure
+ */
+RACEGYM_API void* sim_load_policy(const char* path);
+
+/**
+ * Release a policy handle. Vehicles it is attached to keep using it until detached.
+ * 
+ * @param policy Policy handle
+ */
+RACEGYM_API void sim_free_policy(void* policy);
+
+/**
+ * Evaluate a policy on a batch of inputs.
+ * 
+ * @param policy Policy handle
+ * @param inputs Array of batch * input_size floats
+ * @param batch Number of rows
+ * @param out_outputs Output array of batch * output_size floats
+ * @return Number of floats per output row, or 0 on failure
+ */
+RACEGYM_API int sim_policy_forward(void* policy, const float* inputs, int batch, float* out_outputs);
+
+/**
+ * Let a policy drive a vehicle. At the start of every sim_step (and sim_step_batch)
+ * the observations of all policy-driven vehicles are batched through their policy and the
+ * resulting actions applied, without leaving native code. Two outputs map like the gym
+ * environment (steer, throttle with negative values braking); three map to steer, throttle, brake.
+ * An attached expert driver takes precedence.
+ * 
+ * @param vehicle Pointer to the vehicle
+ * @param policy Policy handle; its input size must match sim_get_observation
+ * @return 0 on success, non-zero if the policy's shape does not fit
+ */
+RACEGYM_API int sim_attach_policy(void* vehicle, void* policy);
+
+/**
+ * Return a vehicle's controls to the caller.
+ * 
+ * @param vehicle Pointer to the vehicle
+ */
+RACEGYM_API void sim_detach_policy(void* vehicle);
+
+/**
+ * Copy the full dynamic state of a vehicle (see SIM_VEHICLE_STATE_SIZE).
+ * 
+ * @param vehicle Pointer to the vehicle
+ * @param out_state Output array of SIM_VEHICLE_STATE_SIZE floats
+ */
+RACEGYM_API void sim_get_vehicle_state(void* vehicle, float* out_state);
+
+/**
+ * Overwrite the full dynamic state of a vehicle and re-seed its track progress
+ * from the new position.
+ * 
+ * @param sim_context Pointer to simulation context
+ * @param vehicle Pointer to the vehicle
+ * @param state Array of SIM_VEHICLE_STATE_SIZE floats
+ */
+RACEGYM_API void sim_set_vehicle_state(void* sim_context, void* vehicle, const float* state);
+
+/**
+ * Advance several headless simulation contexts by one step each, in parallel.
+ * Equivalent to calling sim_step on each context, but never renders.
+ * The contexts must be distinct.
+ * 
+ * @param sim_contexts Array of simulation context pointers
+ * @param count Number of contexts
+ */
+RACEGYM_API void sim_step_batch(void** sim_contexts, int count);
+
+/**
+ * Linearize one sim step around a vehicle state and control using forward finite differences.
+ * The rollouts run in private copies that share the context's track, so the context itself
+ * is not modified. Jacobians are row-major: entry [i][j] is d next_state[i] / d input[j].
+ * The step starts from the orientation quaternion normalised, so the orientation columns are
+ * derivatives through q / |q| (scaling q has no effect), as in sim_compute_vehicle_jacobian_exact.
+ * 
+ * @param sim_context Pointer to simulation context (provides the track)
+ * @param state Array of SIM_VEHICLE_STATE_SIZE floats
+ * @param control Array of SIM_VEHICLE_CONTROL_SIZE floats: steer, throttle, brake
+ * @param epsilon Relative perturbation size, or <= 0 for the default (1e-3)
+ * @param out_next_state Output array of SIM_VEHICLE_STATE_SIZE floats, or null
+ * @param out_state_jacobian Output array of SIM_VEHICLE_STATE_SIZE * SIM_VEHICLE_STATE_SIZE floats, or null
+ * @param out_control_jacobian Output array of SIM_VEHICLE_STATE_SIZE * SIM_VEHICLE_CONTROL_SIZE floats, or null
+ * @return 0 on success, non-zero if no track is loaded or inputs are missing
+ */
+RACEGYM_API int sim_compute_vehicle_jacobian(void* sim_context, const float* state, const float* control,
+                                             float epsilon, float* out_next_state,
+                                             float* out_state_jacobian, float* out_control_jacobian);
+
+/**
+ * Exact Jacobians of one sim step, computed by running the vehicle dynamics on dual numbers
+ * (forward-mode automatic differentiation). Same layout as sim_compute_vehicle_jacobian.
+ * Derivatives are those of the branch taken at the given point; contact changes and clamps
+ * are not smoothed.
+ * 
+ * @param state Array of SIM_VEHICLE_STATE_SIZE floats
+ * @param control Array of SIM_VEHICLE_CONTROL_SIZE floats: steer, throttle, brake
+ * @param out_next_state Output array of SIM_VEHICLE_STATE_SIZE floats, or null
+ * @param out_state_jacobian Output array of SIM_VEHICLE_STATE_SIZE * SIM_VEHICLE_STATE_SIZE floats, or null
+ * @param out_control_jacobian Output array of SIM_VEHICLE_STATE_SIZE * SIM_VEHICLE_CONTROL_SIZE floats, or null
+ * @return 0 on success, non-zero if inputs are missing
+ */
+RACEGYM_API int sim_compute_vehicle_jacobian_exact(const float* state, const float* control,
+                                                   float* out_next_state, float* out_state_jacobian,
+                                                   float* out_control_jacobian);
+
+/**
+ * Roll out many candidate control sequences from one vehicle state, for sampling-based
+ * planners (MPC, CEM, MPPI). Candidates are stepped in parallel, natively, without
+ * touching the context's own vehicles.
+ * 
+ * @param sim_context Pointer to simulation context (provides the track)
+ * @param vehicle Vehicle the start state was read from, whose wheel contacts seed the
+ *        candidates' off-track check, or null to start them with no contacts
+ * @param state Start state, SIM_VEHICLE_STATE_SIZE floats (see sim_get_vehicle_state)
+ * @param actions Controls as [num_candidates][horizon][SIM_VEHICLE_CONTROL_SIZE] floats
+ * @param num_candidates Number of candidate sequences (K)
+ * @param horizon Steps per sequence (H); each step is one sim_step
+ * @param cost Cost weights, or null for the defaults {1, 1, 10, 0}
+ * @param out_costs Output array of num_candidates floats
+ * @param out_final_states Output array of num_candidates * SIM_VEHICLE_STATE_SIZE floats, or null
+ * @return 0 on success, non-zero if no track is loaded or arguments are invalid
+ */
+RACEGYM_API int sim_rollout_batch(void* sim_context, void* vehicle, const float* state, const float* actions,
+                                  int num_candidates, int horizon, const SimRolloutCost* cost,
+                                  float* out_costs, float* out_final_states);
+
+/**
+ * Create a batch of environments with the episode logic of racegym/env.py (reward,
+ * termination, truncation, lap timing) done natively, one context and vehicle each.
+ * Finished episodes reset automatically. Call sim_vec_env_set_buffers, then sim_vec_env_reset.
+ * 
+ * @param track_set Pointer returned by sim_load_track_set; must outlive the batch
+ * @param num_envs Number of environments
+ * @param fixed_start If non-zero, spawn just before the start line instead of at random
+ * @param max_episode_steps Steps after which an episode is truncated
+ * @return Opaque batch handle, or nullptr on failure
+ */
+RACEGYM_API void* sim_vec_env_create(void* track_set, int num_envs, int fixed_start, int max_episode_steps);
+
+/**
+ * Free a batch created by sim_vec_env_create.
+ * 
+ * @param vec_env Batch handle
+ */
+RACEGYM_API void sim_vec_env_free(void* vec_env);
+
+/**
+ * Point a batch at caller-owned arrays, one row per environment. The batch reads actions
+ * and writes results there on every reset and step; the arrays may live in shared memory.
+ * 
+ * @param vec_env Batch handle
+ * @param actions Input [num_envs][2]: steer, throttle (negative values brake)
+ * @param observations Output [num_envs][83], already reset for finished episodes
+ * @param rewards Output [num_envs]
+ * @param terminated Output [num_envs], 1 if the car went off track or crashed
+ * @param truncated Output [num_envs], 1 if the episode hit max_episode_steps
+ * @param lap_times Output [num_envs], lap time in seconds if a lap was completed this step, NaN otherwise
+ * @param terminal_observations Output [num_envs][83], last observation of finished episodes, or null
+ * @return 0 on success, non-zero if a required array is missing
+ */
+RACEGYM_API int sim_vec_env_set_buffers(void* vec_env, const float* actions, float* observations, float* rewards,
+                                        unsigned char* terminated, unsigned char* truncated, float* lap_times,
+                                        float* terminal_observations);
+
+/**
+ * Start a new episode in every environment of a batch and write the observations.
+ * 
+ * @param vec_env Batch handle
+ * @param seed Seed for track selection and spawn points; episode e of environment i draws them
+ *             from the stream sim_random_uniform(seed, i, e, 0), counting episodes from this reset
+ */
+RACEGYM_API void sim_vec_env_reset(void* vec_env, unsigned long long seed);
+
+/**
+ * Choose whether finished episodes reset automatically (the default). With automatic resets
+ * off, an environment whose episode ends keeps its final observation and waits for
+ * sim_vec_env_reset_finished. Steps skip waiting environments entirely; from the step after
+ * the one that finished them, their rows read reward 0, not terminated or truncated and a
+ * NaN lap time.
+ *
+ * @param vec_env Batch handle
+ * @param enabled Non-zero to reset finished episodes automatically
+ * @return 0 on success, non-zero if the handle is missing
+ */
+RACEGYM_API int sim_vec_env_set_autoreset(void* vec_env, int enabled);
+
+/**
+ * Choose whether environments whose physics state diverges (NaN, infinity or runaway
+ * values, checked after every step) reset automatically. Such a step reads reward 0 and
+ * truncated, with the last finite observation as the terminal one, and is counted in the
+ * faulted statistic instead of as an episode. With fault resets off, or automatic resets
+ * off, a faulted environment is quarantined like a finished one until
+ * sim_vec_env_reset_finished. On by default.
+ *
+ * @param vec_env Batch handle
+ * @param enabled Non-zero to reset faulted environments automatically
+ * @return 0 on success, non-zero if the handle is missing
+ */
+RACEGYM_API int sim_vec_env_set_fault_reset(void* vec_env, int enabled);
+
+/**
+ * Start a new episode in every environment waiting for one and write their observations.
+ *
+ * @param vec_env Batch handle
+ * @return Number of environments reset
+ */
+RACEGYM_API int sim_vec_env_reset_finished(void* vec_env);
+
+/**
+ * @param vec_env Batch handle
+ * @return Number of environments that the next step will advance
+ */
+RACEGYM_API int sim_vec_env_get_active_count(void* vec_env);
+
+/**
+ * List the environments whose physics state diverged in the last step.
+ *
+ * @param vec_env Batch handle
+ * @param out_indices Output ascending environment indices, up to max_count of them; may be null
+ * @param max_count Capacity of out_indices
+ * @return Number of faulted environments, which may exceed max_count
+ */
+RACEGYM_API int sim_vec_env_get_faulted(void* vec_env, int* out_indices, int max_count);
+
+/**
+ * Pin each thread of the process-wide stepping pool to its own CPU, leaving the first CPU
+ * of the process affinity mask to the calling thread. Batch environments are created,
+ * reset and stepped with a fixed split over the pool, so with pinned threads each
+ * environment's memory stays on the NUMA node of the CPU that steps it.
+ *
+ * @return 0 on success, non-zero if pinning is unsupported or failed
+ */
+RACEGYM_API int sim_pin_worker_threads(void);
+
+/**
+ * Step several batches at once: every active environment of every batch is stepped in one
+ * parallel pass with its current actions, then results are written to each batch's buffers.
+ * The batches must be distinct.
+ * 
+ * @param vec_envs Array of batch handles
+ * @param count Number of batches
+ */
+RACEGYM_API void sim_vec_env_step_batch(void** vec_envs, int count);
+
+/**
+ * Fetch the statistics of every episode a batch finished since it was created or its
+ * statistics were last reset, replacing per-episode bookkeeping in Python.
+ * 
+ * @param vec_env Batch handle
+ * @param out_stats Output statistics
+ * @param reset If non-zero, clear the statistics after copying them
+ * @return 0 on success, non-zero if arguments are missing
+ */
+RACEGYM_API int sim_vec_env_get_stats(void* vec_env, SimEpisodeStats* out_stats, int reset);
+
+/**
+ * Change the histogram range of one metric and clear that metric. The defaults are
+ * return [-20, 100), length [0, max_episode_steps), distance [0, 100) and lap time [0, 300).
+ * 
+ * @param vec_env Batch handle
+ * @param metric One of the SIM_STAT_* values
+ * @param histogram_min Lower edge of the first bucket
+ * @param histogram_max Upper edge of the last bucket
+ * @return 0 on success, non-zero if the metric is unknown
+ */
+RACEGYM_API int sim_vec_env_set_stats_range(void* vec_env, int metric, float histogram_min, float histogram_max);
+
 /**
  * Get the track normal vector at a given track parameter.
  * 
@@ -0,0 +1,361 @@
+#include "sim_context.h"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <glm/glm.hpp>
+#include "expert_driver.h"
+#include "mlp_policy.h"
+#include "observation.h"
+#include "telemetry.h"
+#include "thread_pool.h"
+#include "track.h"
+#include "vehicle.h"
+
+// Smallest range of vehicles (or bodies) worth handing to another thread
+static const int MIN_VEHICLES_PER_RANGE = 8;
+
+// Size of the contiguous ranges that split count items over the pool's threads
+static int rangeSize(int count) {
+    int numRanges = std::min(ThreadPool::global().getNumThreads(), count / MIN_VEHICLES_PER_RANGE);
+    numRanges = std::max(numRanges, 1);
+    return std::max((count + numRanges - 1) / numRanges, 1);
+}
+
+static int numRanges(int count, int size) {
+    return (count + size - 1) / size;
+}
+
+SimContext::SimContext()
+    : windowed(false), running(false), track(nullptr), nextVehicleId(0), telemetry(nullptr),
+      bodiesPerRange(1), vehiclesPerRange(1), stepGraphSubsteps(0), stepGraphDelta(0.0f),
+      pipelineBusy(false), pipelineStopping(false), stepResultsValid(false) {}
+
+SimContext::~SimContext() {
+    setPipelined(false);
+
+    // Vehicles remove their bodies from the world, so they go first
+    for (auto vehicle : vehicles) {
+        physicsWorld.getArena().destroy(vehicle);
+    }
+    vehicles.clear();
+
+    delete track;
+    delete telemetry;
+}
+
+void SimContext::setTrack(const std::shared_ptr<const TrackData>& data) {
+    discardStepResults();
+    for(auto vehicle : vehicles) {
+        physicsWorld.getArena().destroy(vehicle);
+    }
+    vehicles.clear(); // Clear physics bodies to prevent dangling pointers
+    physicsWorld.resetArena();
+
+    if (track && track->getData() == data) {
+        return;
+    }
+
+    delete track;
+    track = data ? new Track(data) : nullptr;
+}
+
+Vehicle* SimContext::addVehicle(float spawnT) {
+    if(!track) {
+        std::cerr << "Cannot add vehicle: no track loaded." << std::endl;
+        return nullptr;
+    }
+
+    discardStepResults();
+    glm::vec2 startPos = track->getPosition(spawnT);
+    glm::vec2 startTangent = track->getTangent(spawnT);
+    float startAngle = atan2(startTangent.x, startTangent.y);    
+
+    Vehicle *vehicle = physicsWorld.getArena().create<Vehicle>(physicsWorld, glm::vec3(startPos.x, 0.75f, startPos.y), glm::vec3(0.0f, startAngle, 0.0f));
+    vehicle->resetTrackProgress(track);
+    vehicle->telemetryId = nextVehicleId++;
+    vehicles.push_back(vehicle);
+    return vehicle;
+}
+
+void SimContext::removeVehicle(Vehicle* vehicle) {
+    discardStepResults();
+    auto it = std::find(vehicles.begin(), vehicles.end(), vehicle);
+    if (it != vehicles.end()) {
+        vehicles.erase(it);
+        physicsWorld.getArena().destroy(vehicle);
+    }
+    // An env's episode reset removes its only vehicle, so this is where a
+    // context's memory is recycled between episodes
+    if (vehicles.empty()) {
+        physicsWorld.resetArena();
+    }
+}
+
+void SimContext::substep(float deltaTime) {
+    runSubsteps(1, deltaTime);
+}
+
+void SimContext::stepPhysics() {
+    runSubsteps(SUBSTEPS_PER_STEP, SUBSTEP_DELTA);
+    startStepResults();
+}
+
+void SimContext::setPipelined(bool enabled) {
+    if (enabled == isPipelined()) {
+        return;
+    }
+
+    if (enabled) {
+        pipelineStopping = false;
+        pipelineThread = std::thread(&SimContext::pipelineLoop, this);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(pipelineMutex);
+        pipelineStopping = true;
+    }
+    pipelineCondition.notify_all();
+    pipelineThread.join();
+    stepResultsValid = false;
+}
+
+void SimContext::startStepResults() {
+    if (!isPipelined()) {
+        return;
+    }
+
+    // The worker only reads vehicles and track, which nothing changes until the next
+    // discardStepResults, so it needs no lock beyond the hand-over
+    waitForStepResults();
+    stepResults.resize(vehicles.size());
+    {
+        std::lock_guard<std::mutex> lock(pipelineMutex);
+        pipelineBusy = true;
+    }
+    pipelineCondition.notify_all();
+    stepResultsValid = true;
+}
+
+void SimContext::waitForStepResults() {
+    if (!isPipelined()) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(pipelineMutex);
+    pipelineCondition.wait(lock, [this] { return !pipelineBusy; });
+}
+
+void SimContext::discardStepResults() {
+    waitForStepResults();
+    stepResultsValid = false;
+}
+
+const StepResult* SimContext::getStepResult(const Vehicle* vehicle) {
+    if (!stepResultsValid) {
+        return nullptr;
+    }
+    waitForStepResults();
+
+    auto it = std::find(vehicles.begin(), vehicles.end(), vehicle);
+    if (it == vehicles.end()) {
+        return nullptr;
+    }
+    return &stepResults[it - vehicles.begin()];
+}
+
+void SimContext::pipelineLoop() {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(pipelineMutex);
+            pipelineCondition.wait(lock, [this] { return pipelineBusy || pipelineStopping; });
+            if (!pipelineBusy) {
+                return;
+            }
+        }
+
+        for (size_t i = 0; i < stepResults.size(); ++i) {
+            Vehicle* vehicle = vehicles[i];
+            StepResult& result = stepResults[i];
+            if (track) {
+                computeObservation(*track, *vehicle, result.observation, OBSERVATION_SIZE);
+            }
+            result.offTrack = vehicle->isOffTrack(track);
+            result.crashed = isCrashed(vehicle->body->position, vehicle->body->orientation, track);
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(pipelineMutex);
+            pipelineBusy = false;
+        }
+        pipelineCondition.notify_all();
+    }
+}
+
+void SimContext::buildStepGraph(int numSubsteps, float deltaTime) {
+    stepGraph.clear();
+    integrateTasks.clear();
+    vehicleTasks.clear();
+    telemetryTasks.clear();
+
+    int previousVehicles = -1;
+    int previousTelemetry = -1;
+    for (int s = 0; s < numSubsteps; ++s) {
+        int integrate = stepGraph.addTask(0, [this, deltaTime](int range) {
+            int first = range * bodiesPerRange;
+            physicsWorld.stepBodies(first, std::min(bodiesPerRange, physicsWorld.getNumBodies() - first), deltaTime);
+        });
+
+        int vehicleStep = stepGraph.addTask(0, [this, s, deltaTime](int range) {
+            const size_t numVehicles = vehicles.size();
+            const size_t first = static_cast<size_t>(range) * vehiclesPerRange;
+            const size_t last = std::min(first + vehiclesPerRange, numVehicles);
+            for (size_t i = first; i < last; ++i) {
+                Vehicle* vehicle = vehicles[i];
+                if (vehicle->driver && track) {
+                    vehicle->driver->drive(*vehicle, *track);
+                }
+                TelemetryRecord* record = telemetry ? &telemetryRecords[s * numVehicles + i] : nullptr;
+                vehicle->step(deltaTime, record);
+                vehicle->updateTrackProgress(track);
+            }
+        });
+
+        int telemetryWrite = stepGraph.addTask(0, [this, s](int) {
+            telemetry->substep++;
+            for (size_t i = 0; i < vehicles.size(); ++i) {
+                telemetry->write(telemetryRecords[s * vehicles.size() + i]);
+            }
+        });
+
+        if (previousVehicles >= 0) {
+            stepGraph.addDependency(previousVehicles, integrate);
+        }
+        stepGraph.addDependency(integrate, vehicleStep);
+        stepGraph.addDependency(vehicleStep, telemetryWrite);
+        if (previousTelemetry >= 0) {
+            stepGraph.addDependency(previousTelemetry, telemetryWrite);
+        }
+        integrateTasks.push_back(integrate);
+        vehicleTasks.push_back(vehicleStep);
+        telemetryTasks.push_back(telemetryWrite);
+        previousVehicles = vehicleStep;
+        previousTelemetry = telemetryWrite;
+    }
+
+    stepGraphSubsteps = numSubsteps;
+    stepGraphDelta = deltaTime;
+}
+
+void SimContext::runSubsteps(int numSubsteps, float deltaTime) {
+    discardStepResults();
+    if (stepGraph.getNumTasks() == 0 || stepGraphSubsteps != numSubsteps || stepGraphDelta != deltaTime) {
+        buildStepGraph(numSubsteps, deltaTime);
+    }
+
+    // Vehicles can't be added or removed mid-step, so the ranges hold for the whole run
+    const int numBodies = physicsWorld.getNumBodies();
+    const int numVehicles = static_cast<int>(vehicles.size());
+    bodiesPerRange = rangeSize(numBodies);
+    vehiclesPerRange = rangeSize(numVehicles);
+    for (int task : integrateTasks) {
+        stepGraph.setCount(task, numRanges(numBodies, bodiesPerRange));
+    }
+    for (int task : vehicleTasks) {
+        stepGraph.setCount(task, numRanges(numVehicles, vehiclesPerRange));
+    }
+    for (int task : telemetryTasks) {
+        stepGraph.setCount(task, telemetry ? 1 : 0);
+    }
+    if (telemetry) {
+        telemetryRecords.resize(static_cast<size_t>(numSubsteps) * numVehicles);
+    }
+
+    // A field too small to split into several ranges runs entirely on this thread;
+    // otherwise a substep's telemetry write would wake the pool just to overlap the
+    // next integrate. Nested in a batch, the pool runs everything inline anyway.
+    bool split = numRanges(numBodies, bodiesPerRange) > 1 || numRanges(numVehicles, vehiclesPerRange) > 1;
+    stepGraph.run(ThreadPool::global(), split ? 2 : std::numeric_limits<int>::max());
+}
+
+// Rows per forward pass when a large batch is split across the pool
+static const int POLICY_CHUNK_ROWS = 64;
+
+void applyPolicies(SimContext* const* contexts, int count) {
+    struct PolicyRequest {
+        Vehicle* vehicle;
+        const Track* track;
+        const MlpPolicy* policy;
+    };
+
+    std::vector<PolicyRequest> requests;
+    for (int c = 0; c < count; ++c) {
+        SimContext* ctx = contexts[c];
+        if (!ctx || !ctx->track) {
+            continue;
+        }
+        for (auto vehicle : ctx->vehicles) {
+            if (vehicle->policy) {
+                requests.push_back({vehicle, ctx->track, vehicle->policy.get()});
+            }
+        }
+    }
+    if (requests.empty()) {
+        return;
+    }
+
+    // Vehicles sharing a policy become contiguous rows of one batch
+    std::stable_sort(requests.begin(), requests.end(), [](const PolicyRequest& a, const PolicyRequest& b) {
+        return a.policy < b.policy;
+    });
+
+    const int numRequests = static_cast<int>(requests.size());
+    std::vector<float> observations(static_cast<size_t>(numRequests) * OBSERVATION_SIZE);
+    ThreadPool& pool = ThreadPool::global();
+    pool.parallelFor(numRequests, [&](int i) {
+        computeObservation(*requests[i].track, *requests[i].vehicle,
+                           &observations[static_cast<size_t>(i) * OBSERVATION_SIZE], OBSERVATION_SIZE);
+    });
+
+    std::vector<float> actions;
+    for (int start = 0; start < numRequests;) {
+        const MlpPolicy* policy = requests[start].policy;
+        int end = start;
+        while (end < numRequests && requests[end].policy == policy) {
+            ++end;
+        }
+
+        const int rows = end - start;
+        const int outputSize = policy->getOutputSize();
+        actions.resize(static_cast<size_t>(rows) * outputSize);
+
+        const int numChunks = (rows + POLICY_CHUNK_ROWS - 1) / POLICY_CHUNK_ROWS;
+        pool.parallelFor(numChunks, [&](int chunk) {
+            int first = chunk * POLICY_CHUNK_ROWS;
+            int chunkRows = std::min(POLICY_CHUNK_ROWS, rows - first);
+            policy->forward(&observations[static_cast<size_t>(start + first) * OBSERVATION_SIZE], chunkRows,
+                            &actions[static_cast<size_t>(first) * outputSize]);
+        });
+
+        for (int r = 0; r < rows; ++r) {
+            const float* action = &actions[static_cast<size_t>(r) * outputSize];
+            Vehicle* vehicle = requests[start + r].vehicle;
+            // Same action mapping as the gym environment: [steer, throttle - brake],
+            // or raw [steer, throttle, brake]
+            vehicle->setSteerAmount(action[0]);
+            vehicle->setThrottle(action[1]);
+            vehicle->setBrake(outputSize >= 3 ? action[2] : -action[1]);
+        }
+
+        start = end;
+    }
+}
+
+void stepContextBatch(SimContext* const* contexts, int count) {
+    applyPolicies(contexts, count);
+    ThreadPool::global().parallelFor(count, [contexts](int i) {
+        if (contexts[i]) {
+            contexts[i]->stepPhysics();
+        }
+    });
+}
@@ -0,0 +1,120 @@
+#ifndef SIM_CONTEXT_H
+#define SIM_CONTEXT_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "cache_line.h"
+#include "observation.h"
+#include "physics.h"
+#include "task_graph.h"
+
+class Track;
+class TrackData;
+class Vehicle;
+class TelemetryWriter;
+struct TelemetryRecord;
+
+const float SUBSTEP_DELTA = 1.0f / 100.0f; // 0.01 seconds per physics substep
+const int SUBSTEPS_PER_STEP = 10;          // Substeps per sim_step
+
+// What a caller queries about a vehicle after each step
+struct StepResult {
+    float observation[OBSERVATION_SIZE];
+    bool offTrack;
+    bool crashed;
+};
+
+// One independent simulation: a physics world, its vehicles and a view of a
+// (shared) track. Everything a step touches is reachable from here, so
+// distinct contexts can be stepped concurrently. Vehicles, bodies and shapes
+// live in the world's arena: a removed vehicle's slots go to the next one
+// added, and the whole arena is recycled whenever the last vehicle goes.
+struct alignas(CACHE_LINE_SIZE) SimContext {
+    bool windowed;
+    bool running;
+    PhysicsWorld physicsWorld;
+    Track* track;
+    std::vector<Vehicle*> vehicles;
+    uint32_t nextVehicleId;
+    TelemetryWriter* telemetry;
+
+    SimContext();
+    ~SimContext();
+
+    SimContext(const SimContext&) = delete;
+    SimContext& operator=(const SimContext&) = delete;
+
+    // Point the context at new track data. Vehicles are removed because their
+    // track progress refers to the old track. Keeps the existing view when the
+    // data is unchanged.
+    void setTrack(const std::shared_ptr<const TrackData>& data);
+
+    // Spawn a vehicle on the track centreline; nullptr if no track is loaded
+    Vehicle* addVehicle(float spawnT);
+    void removeVehicle(Vehicle* vehicle);
+
+    // Advance the world and every vehicle by one physics substep
+    void substep(float deltaTime);
+    // Advance by one full step without rendering
+    void stepPhysics();
+
+    // Pipelined mode: once a step's physics is done, a worker thread computes every
+    // vehicle's StepResult while the caller carries on (e.g. running its policy).
+    // Anything that changes vehicle state waits for the worker first; controls
+    // don't feed into the results, so setting them never waits.
+    void setPipelined(bool enabled);
+    bool isPipelined() const { return pipelineThread.joinable(); }
+    // Hand the current state to the worker; no-op unless pipelined
+    void startStepResults();
+    // Wait for the worker and drop its results, before vehicle state changes
+    void discardStepResults();
+    // Results of the last step, waiting for them if needed; nullptr if there are
+    // none for this vehicle (not pipelined, or state changed since the step)
+    const StepResult* getStepResult(const Vehicle* vehicle);
+
+private:
+    // Each substep is a chain of graph tasks: integrate the world, then step every
+    // vehicle, then write their telemetry in vehicle order. Large fields split the
+    // bodies and vehicles into contiguous per-thread ranges; the graph puts a barrier
+    // between the phases, and the telemetry of one substep overlaps the next
+    // substep's integrate. Fields of a single range run the whole graph on the
+    // calling thread. Cars don't collide with each other, so vehicles only touch
+    // their own body and the ranges need no merging.
+    void runSubsteps(int numSubsteps, float deltaTime);
+    void buildStepGraph(int numSubsteps, float deltaTime);
+
+    TaskGraph stepGraph;
+    std::vector<int> integrateTasks; // Per substep; one item per range of bodies
+    std::vector<int> vehicleTasks;   // Per substep; one item per range of vehicles
+    std::vector<int> telemetryTasks; // Per substep; one item when telemetry is on
+    int bodiesPerRange;
+    int vehiclesPerRange;
+    int stepGraphSubsteps;
+    float stepGraphDelta;
+    std::vector<TelemetryRecord> telemetryRecords; // [substep][vehicle] of the running step
+
+    void waitForStepResults();
+    void pipelineLoop();
+
+    std::thread pipelineThread;
+    std::mutex pipelineMutex;
+    std::condition_variable pipelineCondition;
+    bool pipelineBusy;     // The worker owns stepResults until it clears this
+    bool pipelineStopping;
+    bool stepResultsValid;
+    std::vector<StepResult> stepResults; // Parallel to vehicles
+};
+
+// Set the controls of every policy-driven vehicle in the contexts. Observations are
+// gathered across all contexts so each policy runs as one batched forward pass.
+void applyPolicies(SimContext* const* contexts, int count);
+
+// Step many contexts by one full step each, in parallel on the global pool,
+// after letting attached policies choose their controls
+void stepContextBatch(SimContext* const* contexts, int count);
+
+#endif // SIM_CONTEXT_H
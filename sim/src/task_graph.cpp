@@ -0,0 +1,98 @@
+#include "task_graph.h"
+#include <algorithm>
+#include <iostream>
+#include <utility>
+#include "thread_pool.h"
+
+TaskGraph::TaskGraph()
+    : wavesValid(true)
+{
+}
+
+int TaskGraph::addTask(int count, TaskFn fn, bool staticSchedule)
+{
+    tasks.push_back({count, std::move(fn), staticSchedule, {}});
+    wavesValid = false;
+    return static_cast<int>(tasks.size()) - 1;
+}
+
+void TaskGraph::addDependency(int before, int after)
+{
+    // Ids are handed out in insertion order, so this also rules out cycles
+    if (before < 0 || after >= getNumTasks() || before >= after)
+    {
+        std::cerr << "TaskGraph: invalid dependency " << before << " -> " << after << std::endl;
+        return;
+    }
+    tasks[after].dependencies.push_back(before);
+    wavesValid = false;
+}
+
+void TaskGraph::clear()
+{
+    tasks.clear();
+    waves.clear();
+    wavesValid = true;
+}
+
+void TaskGraph::buildWaves()
+{
+    // Dependencies always have lower ids, so one pass in id order settles every depth
+    std::vector<int> depth(tasks.size(), 0);
+    waves.clear();
+    for (int t = 0; t < getNumTasks(); ++t)
+    {
+        for (int dependency : tasks[t].dependencies)
+        {
+            depth[t] = std::max(depth[t], depth[dependency] + 1);
+        }
+        int wave = depth[t];
+        if (wave >= static_cast<int>(waves.size()))
+            waves.resize(wave + 1);
+        waves[wave].push_back(t);
+    }
+    wavesValid = true;
+}
+
+void TaskGraph::run(ThreadPool& pool, int minParallelItems)
+{
+    if (!wavesValid)
+        buildWaves();
+
+    for (const auto& wave : waves)
+    {
+        int numTasks = static_cast<int>(wave.size());
+        waveOffsets.resize(numTasks + 1);
+        waveOffsets[0] = 0;
+        for (int w = 0; w < numTasks; ++w)
+        {
+            waveOffsets[w + 1] = waveOffsets[w] + std::max(tasks[wave[w]].count, 0);
+        }
+        int numItems = waveOffsets[numTasks];
+
+        if (numItems < minParallelItems)
+        {
+            for (int w = 0; w < numTasks; ++w)
+            {
+                const Task& task = tasks[wave[w]];
+                for (int i = 0; i < task.count; ++i)
+                {
+                    task.fn(i);
+                }
+            }
+            continue;
+        }
+
+        if (numTasks == 1 && tasks[wave[0]].staticSchedule)
+        {
+            pool.parallelForStatic(numItems, tasks[wave[0]].fn);
+            continue;
+        }
+
+        // Items of all tasks in the wave share one loop; each finds its task by offset
+        pool.parallelFor(numItems, [&](int item) {
+            int w = static_cast<int>(std::upper_bound(waveOffsets.begin(), waveOffsets.end(), item) - waveOffsets.begin()) - 1;
+            tasks[wave[w]].fn(item - waveOffsets[w]);
+        });
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef TASK_GRAPH_H
+
+#define TASK_GRAPH_H
+
+#include <functional>
+#include <vector>
+
+class ThreadPool;
+
+// Static graph of data-parallel tasks run on a ThreadPool. A task is a body
+// fn(i) over [0, count) that starts only once every task it depends on has
+// finished. Tasks are grouped into waves by dependency depth and each wave runs
+// as one parallelFor, so the schedule depends only on the graph: tasks that
+// write disjoint data give the same results on any number of threads, and
+// anything order-sensitive belongs in a task with a count of 1.
+class TaskGraph
+{
+public:
+    using TaskFn = std::function<void(int)>;
+
+    TaskGraph();
+
+    // Returns the task id. Counts may be changed later, e.g. as a context
+    // gains vehicles, without rebuilding the graph. A static task alone in its
+    // wave runs with ThreadPool::parallelForStatic, so each item stays on the
+    // thread that owns it.
+    int addTask(int count, TaskFn fn, bool staticSchedule = false);
+    void setCount(int task, int count) { tasks[task].count = count; }
+    // before must have been added before after
+    void addDependency(int before, int after);
+    void clear();
+
+    int getNumTasks() const { return static_cast<int>(tasks.size()); }
+
+    // Run every task once; not reentrant. Waves with fewer than minParallelItems items in
+    // total run on the calling thread instead of waking the pool.
+    void run(ThreadPool& pool, int minParallelItems = 1);
+
+private:
+    struct Task
+    {
+        int count;
+        TaskFn fn;
+        bool staticSchedule;
+        std::vector<int> dependencies;
+    };
+
+    void buildWaves();
+
+    std::vector<Task> tasks;
+    std::vector<std::vector<int>> waves; // Task ids per wave, in id order
+    std::vector<int> waveOffsets;        // Scratch: first item of each task in the running wave
+    bool wavesValid;
+};
+
+#endif // TASK_GRAPH_H
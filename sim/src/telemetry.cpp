@@ -0,0 +1,63 @@
+#include "telemetry.h"
+
+#include <cstring>
+#include <new>
+
+static const char TELEMETRY_MAGIC[8] = {'R', 'G', 'T', 'E', 'L', 'E', 'M', '\0'};
+static const uint32_t TELEMETRY_VERSION = 1;
+
+TelemetryWriter::TelemetryWriter()
+    : substep(0), header(nullptr), slots(nullptr), nextIndex(0)
+{
+}
+
+TelemetryWriter* TelemetryWriter::create(const char* name, int capacity)
+{
+    if (!name || capacity <= 0)
+        return nullptr;
+
+    TelemetryWriter* writer = new TelemetryWriter();
+    size_t size = sizeof(TelemetryHeader) + static_cast<size_t>(capacity) * sizeof(TelemetrySlot);
+    if (!writer->region.create(name, size))
+    {
+        delete writer;
+        return nullptr;
+    }
+
+    // The region is zero-filled, which is a valid state for every counter
+    char* base = static_cast<char*>(writer->region.getData());
+    writer->header = new (base) TelemetryHeader();
+    writer->slots = reinterpret_cast<TelemetrySlot*>(base + sizeof(TelemetryHeader));
+    for (int i = 0; i < capacity; ++i)
+    {
+        new (&writer->slots[i]) TelemetrySlot();
+    }
+
+    TelemetryHeader* header = writer->header;
+    header->version = TELEMETRY_VERSION;
+    header->capacity = static_cast<uint32_t>(capacity);
+    header->slotSize = sizeof(TelemetrySlot);
+    header->headerSize = sizeof(TelemetryHeader);
+    header->writeIndex.store(0, std::memory_order_relaxed);
+
+    // Publish the magic last so readers never see a half-initialised header
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(header->magic, TELEMETRY_MAGIC, sizeof(header->magic));
+
+    return writer;
+}
+
+void TelemetryWriter::write(const TelemetryRecord& record)
+{
+    uint64_t index = nextIndex++;
+    TelemetrySlot& slot = slots[index % header->capacity];
+
+    slot.sequence.store(2 * index + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.record = record;
+    slot.record.substep = substep;
+
+    slot.sequence.store(2 * index + 2, std::memory_order_release);
+    header->writeIndex.store(index + 1, std::memory_order_release);
+}
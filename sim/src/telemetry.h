@@ -0,0 +1,74 @@
+#ifndef TELEMETRY_H
+
+#define TELEMETRY_H
+
+#include <atomic>
+#include <cstdint>
+#include "shared_memory.h"
+
+// One record per vehicle per physics substep. Layout is fixed; external
+// readers (racegym/telemetry.py) decode it by offset.
+struct TelemetryRecord
+{
+    uint64_t substep;          // Context substep counter
+    uint32_t vehicleId;        // Stable per-context vehicle id
+    float speed;               // m/s
+    float yawRate;             // rad/s
+    float steer;
+    float throttle;
+    float brake;
+    float slipRatio[4];        // Per wheel: FR, FL, RR, RL
+    float slipAngle[4];        // rad
+    float normalForce[4];      // N
+    float longitudinalForce[4];// N
+    float lateralForce[4];     // N
+};
+
+// Each slot carries a sequence counter: odd while being written, 2 * (index + 1)
+// once record index is complete. Readers copy the record and re-check the
+// counter, so they never block the writer and detect overwritten slots.
+struct TelemetrySlot
+{
+    std::atomic<uint64_t> sequence;
+    uint64_t reserved;
+    TelemetryRecord record;
+};
+
+struct TelemetryHeader
+{
+    char magic[8];                    // "RGTELEM"
+    uint32_t version;
+    uint32_t capacity;                // Number of slots
+    uint32_t slotSize;
+    uint32_t headerSize;
+    std::atomic<uint64_t> writeIndex; // Index of the next record to be written
+    uint64_t reserved[4];
+};
+
+static_assert(sizeof(TelemetryRecord) == 112, "TelemetryRecord layout is shared with external readers");
+static_assert(sizeof(TelemetrySlot) == 128, "TelemetrySlot layout is shared with external readers");
+static_assert(sizeof(TelemetryHeader) == 64, "TelemetryHeader layout is shared with external readers");
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "Telemetry counters must be lock-free to live in shared memory");
+
+// Single-producer ring buffer of telemetry records in named shared memory.
+// When a reader falls behind, the oldest records are overwritten.
+class TelemetryWriter
+{
+public:
+    // nullptr if the shared memory region could not be created
+    static TelemetryWriter* create(const char* name, int capacity);
+
+    void write(const TelemetryRecord& record);
+
+    uint64_t substep; // Stamped into every record; advanced by the owner
+
+private:
+    TelemetryWriter();
+
+    SharedMemoryRegion region;
+    TelemetryHeader* header;
+    TelemetrySlot* slots;
+    uint64_t nextIndex;
+};
+
+#endif // TELEMETRY_H
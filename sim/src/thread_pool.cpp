@@ -0,0 +1,250 @@
+#include "thread_pool.h"
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <pthread.h>
+#if defined(__linux__)
+#include <sched.h>
+#endif
+#endif
+
+static thread_local bool t_insidePoolTask = false;
+static int g_forkedWorkers = 0; // Workers of the global pool to restart after a fork
+
+ThreadPool::ThreadPool(int numThreads)
+    : task(nullptr), taskCount(0), taskStatic(false), nextIndex(0), activeWorkers(0), generation(0), stopping(false),
+      pinned(false)
+{
+    if (numThreads <= 0)
+    {
+        int hardwareThreads = static_cast<int>(std::thread::hardware_concurrency());
+        numThreads = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+    }
+
+    startWorkers(numThreads);
+}
+
+ThreadPool::~ThreadPool()
+{
+    stopWorkers();
+}
+
+void ThreadPool::startWorkers(int count)
+{
+    stopping = false;
+    generation = 0;
+    workers.reserve(count);
+    for (int i = 0; i < count; ++i)
+    {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+void ThreadPool::stopWorkers()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+    workers.clear();
+}
+
+ThreadPool& ThreadPool::global()
+{
+    // Intentionally leaked: joining workers from static destructors during
+    // library unload can deadlock on Windows
+    static ThreadPool* pool = [] {
+        ThreadPool* created = new ThreadPool();
+#if !defined(_WIN32)
+        pthread_atfork(&ThreadPool::beforeFork, &ThreadPool::afterForkInParent, &ThreadPool::afterForkInChild);
+#endif
+        return created;
+    }();
+    return *pool;
+}
+
+// Only the forking thread exists in the child, so workers left running would be
+// missing there, and a loop in flight would never finish. The forking thread holds
+// submitMutex across the fork, which keeps other threads from starting a loop.
+void ThreadPool::beforeFork()
+{
+    ThreadPool& pool = global();
+    pool.submitMutex.lock();
+    g_forkedWorkers = static_cast<int>(pool.workers.size());
+    pool.stopWorkers();
+}
+
+void ThreadPool::afterForkInParent()
+{
+    ThreadPool& pool = global();
+    pool.startWorkers(g_forkedWorkers);
+    if (pool.pinned)
+        pool.pinWorkers();
+    pool.submitMutex.unlock();
+}
+
+void ThreadPool::afterForkInChild()
+{
+    ThreadPool& pool = global();
+    pool.pinned = false;
+    pool.startWorkers(g_forkedWorkers);
+    pool.submitMutex.unlock();
+}
+
+void ThreadPool::parallelFor(int count, const std::function<void(int)>& fn)
+{
+    submit(count, fn, false);
+}
+
+void ThreadPool::parallelForStatic(int count, const std::function<void(int)>& fn)
+{
+    submit(count, fn, true);
+}
+
+void ThreadPool::getStaticBlock(int count, int participant, int& first, int& last) const
+{
+    long long numParticipants = getNumThreads();
+    first = static_cast<int>(count * static_cast<long long>(participant) / numParticipants);
+    last = static_cast<int>(count * static_cast<long long>(participant + 1) / numParticipants);
+}
+
+void ThreadPool::submit(int count, const std::function<void(int)>& fn, bool staticSchedule)
+{
+    if (count <= 0)
+        return;
+
+    // Nested loops and trivial loops are not worth waking the workers for
+    if (t_insidePoolTask || workers.empty() || count == 1)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            fn(i);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> submitLock(submitMutex);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        task = &fn;
+        taskCount = count;
+        taskStatic = staticSchedule;
+        nextIndex.store(0, std::memory_order_relaxed);
+        activeWorkers = static_cast<int>(workers.size());
+        ++generation;
+    }
+    wakeCondition.notify_all();
+
+    // The caller is the last participant
+    runTasks(static_cast<int>(workers.size()));
+
+    std::unique_lock<std::mutex> lock(mutex);
+    doneCondition.wait(lock, [this] { return activeWorkers == 0; });
+    task = nullptr;
+}
+
+void ThreadPool::runTasks(int participant)
+{
+    t_insidePoolTask = true;
+    if (taskStatic)
+    {
+        int first, last;
+        getStaticBlock(taskCount, participant, first, last);
+        for (int i = first; i < last; ++i)
+        {
+            (*task)(i);
+        }
+    }
+    else
+    {
+        for (int i = nextIndex.fetch_add(1, std::memory_order_relaxed); i < taskCount; i = nextIndex.fetch_add(1, std::memory_order_relaxed))
+        {
+            (*task)(i);
+        }
+    }
+    t_insidePoolTask = false;
+}
+
+bool ThreadPool::pinWorkers()
+{
+#if defined(__linux__)
+    cpu_set_t allowed;
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+        return false;
+    std::vector<int> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    {
+        if (CPU_ISSET(cpu, &allowed))
+            cpus.push_back(cpu);
+    }
+    if (cpus.empty())
+        return false;
+
+    bool ok = true;
+    for (size_t w = 0; w < workers.size(); ++w)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpus[(w + 1) % cpus.size()], &set);
+        ok = pthread_setaffinity_np(workers[w].native_handle(), sizeof(set), &set) == 0 && ok;
+    }
+    pinned = ok;
+    return ok;
+#elif defined(_WIN32)
+    DWORD_PTR processMask = 0, systemMask = 0;
+    if (!GetProcessAffinityMask(GetCurrentProcess(), &processMask, &systemMask) || processMask == 0)
+        return false;
+    std::vector<DWORD_PTR> cpus;
+    for (int cpu = 0; cpu < static_cast<int>(sizeof(DWORD_PTR) * 8); ++cpu)
+    {
+        if (processMask & (static_cast<DWORD_PTR>(1) << cpu))
+            cpus.push_back(static_cast<DWORD_PTR>(1) << cpu);
+    }
+
+    bool ok = true;
+    for (size_t w = 0; w < workers.size(); ++w)
+    {
+        ok = SetThreadAffinityMask(workers[w].native_handle(), cpus[(w + 1) % cpus.size()]) != 0 && ok;
+    }
+    pinned = ok;
+    return ok;
+#else
+    return false;
+#endif
+}
+
+void ThreadPool::workerLoop(int index)
+{
+    unsigned long long seenGeneration = 0;
+
+    while (true)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wakeCondition.wait(lock, [&] { return stopping || generation != seenGeneration; });
+            if (stopping)
+                return;
+            seenGeneration = generation;
+        }
+
+        runTasks(index);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --activeWorkers;
+        }
+        doneCondition.notify_one();
+    }
+}
@@ -0,0 +1,76 @@
+#ifndef THREAD_POOL_H
+
+#define THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool of worker threads for data-parallel loops. The calling
+// thread takes part in every loop, so a pool of N threads runs N + 1 ways.
+class ThreadPool
+{
+public:
+    // numThreads <= 0 uses one worker per hardware thread, minus the caller
+    explicit ThreadPool(int numThreads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int getNumThreads() const { return static_cast<int>(workers.size()) + 1; }
+
+    // Run fn(i) for every i in [0, count) and block until all calls return.
+    // Calls made from inside a pool task run serially on the calling thread.
+    void parallelFor(int count, const std::function<void(int)>& fn);
+
+    // As parallelFor, but thread p of the pool always runs the p-th contiguous block of
+    // [0, count). Loops over the same count touch each item from the same thread, so
+    // state allocated in one such loop is first-touched (placed on the NUMA node of)
+    // the thread that keeps working on it.
+    void parallelForStatic(int count, const std::function<void(int)>& fn);
+
+    // The block [first, last) of [0, count) that thread participant runs in parallelForStatic
+    void getStaticBlock(int count, int participant, int& first, int& last) const;
+
+    // Pin each worker to its own CPU from the process affinity mask, leaving the first
+    // to the calling thread. Returns false where unsupported.
+    bool pinWorkers();
+
+    // Process-wide pool shared by all contexts. On POSIX it survives fork(): its
+    // workers are stopped before the fork and fresh ones are started in the parent
+    // (re-pinned if they were) and the child (unpinned).
+    static ThreadPool& global();
+
+private:
+    void startWorkers(int count);
+    void stopWorkers();
+    static void beforeFork();
+    static void afterForkInParent();
+    static void afterForkInChild();
+
+    void submit(int count, const std::function<void(int)>& fn, bool staticSchedule);
+    void workerLoop(int index);
+    void runTasks(int participant);
+
+    std::vector<std::thread> workers;
+
+    std::mutex submitMutex; // Serialises parallelFor callers
+    std::mutex mutex;
+    std::condition_variable wakeCondition;
+    std::condition_variable doneCondition;
+
+    const std::function<void(int)>* task;
+    int taskCount;
+    bool taskStatic;
+    std::atomic<int> nextIndex;
+    int activeWorkers;
+    unsigned long long generation;
+    bool stopping;
+    bool pinned;
+};
+
+#endif // THREAD_POOL_H
@@ -2,30 +2,28 @@
 
 #define TRACK_H
 
+#include <memory>
 #include <vector>
 #include <glm/glm.hpp>
-#include "renderer.h"
+#include "track_data.h"
 
+// Per-context view of a track. The geometry lives in a shared, immutable
+// TrackData; the view only adds state that belongs to one context.
 class Track {
-    std::vector<glm::vec2> points;
-    int numSegments;
-
-    Mesh trackMesh;
-
-    bool loadPointsFromFile(const char* path);
-    void generateGeometry();
+    std::shared_ptr<const TrackData> data;
 
 public:
-    Track(const char* path);
-    ~Track();
+    explicit Track(std::shared_ptr<const TrackData> data);
+
+    const std::shared_ptr<const TrackData>& getData() const { return data; }
 
-    void draw(int locModel, int locColor);
-    glm::vec2 getPosition(float t);
-    glm::vec2 getTangent(float t);
-    glm::vec2 getNormal(float t);
-    float getClosestT(const glm::vec2& position);
-    std::vector<glm::vec3> getWaypoints(float currentT, int numWaypoints, float waypointSpacing);
-    int getNumSegments() const { return numSegments; }
+    glm::vec2 getPosition(float t) const { return data->getPosition(t); }
+    glm::vec2 getTangent(float t) const { return data->getTangent(t); }
+    glm::vec2 getNormal(float t) const { return data->getNormal(t); }
+    float getClosestT(const glm::vec2& position) const { return data->getClosestT(position); }
+    float getClosestTNear(const glm::vec2& position, float hintT) const { return data->getClosestTNear(position, hintT); }
+    std::vector<glm::vec3> getWaypoints(float currentT, int numWaypoints, float waypointSpacing) const { return data->getWaypoints(currentT, numWaypoints, waypointSpacing); }
+    int getNumSegments() const { return data->getNumSegments(); }
 };
 
-#endif // TRACK_H
\ No newline at end of file
+#endif // TRACK_H
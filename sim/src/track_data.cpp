@@ -0,0 +1,587 @@
+#include "track_data.h"
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cctype>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <mutex>
+#include <unordered_map>
+#include <filesystem>
+#include <vector>
+
+// Compiled track layout: header, control points, then the centreline LUT.
+// Offsets are in bytes from the start of the file.
+struct CompiledTrackHeader
+{
+	char magic[4];
+	uint32_t version;
+	uint32_t numPoints;
+	uint32_t numSamples;
+	uint32_t pointsOffset;
+	uint32_t samplesOffset;
+};
+
+static const char COMPILED_TRACK_MAGIC[4] = {'R', 'G', 'T', 'K'};
+static const uint32_t COMPILED_TRACK_VERSION = 1;
+
+static_assert(sizeof(glm::vec2) == 2 * sizeof(float), "glm::vec2 must be tightly packed");
+static_assert(sizeof(TrackSample) == 5 * sizeof(float), "TrackSample must be tightly packed");
+
+static std::mutex sharedTracksMutex;
+static std::unordered_map<std::string, std::weak_ptr<const TrackData>> sharedTracks;
+
+TrackData::TrackData()
+	: points(nullptr), numPoints(0), samples(nullptr), numSamples(0), numSegments(0)
+{
+}
+
+std::shared_ptr<const TrackData> TrackData::load(const char *path)
+{
+	std::shared_ptr<TrackData> data(new TrackData());
+	if (!data->loadCompiled(path) && !data->loadPointsFromFile(path))
+		return nullptr;
+	return data;
+}
+
+std::shared_ptr<const TrackData> TrackData::loadShared(const char *path)
+{
+	if (!path)
+		return nullptr;
+
+	std::error_code ec;
+	std::string key = std::filesystem::weakly_canonical(path, ec).string();
+	if (ec)
+		key = path;
+
+	{
+		std::lock_guard<std::mutex> lock(sharedTracksMutex);
+		auto it = sharedTracks.find(key);
+		if (it != sharedTracks.end())
+		{
+			if (std::shared_ptr<const TrackData> existing = it->second.lock())
+				return existing;
+		}
+	}
+
+	// Load outside the lock so different tracks can load concurrently
+	std::shared_ptr<const TrackData> data = load(path);
+	if (!data)
+		return nullptr;
+
+	std::lock_guard<std::mutex> lock(sharedTracksMutex);
+	// Drop tracks nobody holds any more so cycling through paths doesn't grow the map
+	for (auto it = sharedTracks.begin(); it != sharedTracks.end();)
+	{
+		if (it->second.expired())
+			it = sharedTracks.erase(it);
+		else
+			++it;
+	}
+	std::weak_ptr<const TrackData> &slot = sharedTracks[key];
+	if (std::shared_ptr<const TrackData> existing = slot.lock())
+		return existing; // Another thread won the race; drop our copy
+	slot = data;
+	return data;
+}
+
+glm::vec2 TrackData::getPosition(float t) const
+{
+	int segment = static_cast<int>(t) % numSegments;
+	glm::vec2 p0 = points[segment * 2];
+	glm::vec2 p1 = points[segment * 2 + 1];
+	glm::vec2 p2 = points[(segment * 2 + 2) % numPoints];
+	float localT = t - std::floor(t);
+	float invT = 1.0f - localT;
+	return invT * invT * p0 + 2.0f * invT * localT * p1 + localT * localT * p2;
+}
+
+glm::vec2 TrackData::getTangent(float t) const
+{
+	const float delta = 0.001f;
+	glm::vec2 p1 = getPosition(t);
+	glm::vec2 p2 = getPosition(t + delta);
+	return glm::normalize(p2 - p1);
+}
+
+glm::vec2 TrackData::getNormal(float t) const
+{
+	glm::vec2 tangent = getTangent(t);
+	return glm::vec2(-tangent.y, tangent.x); // 90 degree rotation
+}
+
+static void skipWhitespace(const std::string &s, size_t &i)
+{
+	while (i < s.size() && std::isspace(static_cast<unsigned char>(s[i])))
+		++i;
+}
+
+// Very minimal JSON loader expecting: { "points": [[x,y], [x,y], ...] }
+bool TrackData::loadPointsFromFile(const char *path)
+{
+	if (!path)
+		return false;
+	std::ifstream f(path);
+	if (!f.is_open())
+		return false;
+	std::stringstream buffer;
+	buffer << f.rdbuf();
+	std::string json = buffer.str();
+
+	ownedPoints.clear();
+
+	size_t i = 0;
+	skipWhitespace(json, i);
+	if (i >= json.size() || json[i] != '{')
+		return false;
+	++i;
+	// find "points"
+	while (i < json.size())
+	{
+		skipWhitespace(json, i);
+		if (json[i] == '}')
+			break;
+		if (json[i] == '"')
+		{
+			++i;
+			size_t start = i;
+			while (i < json.size() && json[i] != '"')
+				++i;
+			std::string key = json.substr(start, i - start);
+			if (i < json.size())
+				++i; // skip closing quote
+			skipWhitespace(json, i);
+			if (i >= json.size() || json[i] != ':')
+				return false;
+			++i;
+			skipWhitespace(json, i);
+			if (key == "points")
+			{
+				if (i >= json.size() || json[i] != '[')
+					return false;
+				++i; // start array
+				// parse array of [x,y]
+				while (i < json.size())
+				{
+					skipWhitespace(json, i);
+					if (json[i] == ']')
+					{
+						++i;
+						break;
+					}
+					if (json[i] != '[')
+						return false;
+					++i; // start point
+					skipWhitespace(json, i);
+					// parse x
+					size_t numStart = i;
+					while (i < json.size() && (std::isdigit(static_cast<unsigned char>(json[i])) || json[i] == '-' || json[i] == '+' || json[i] == '.' || json[i] == 'e' || json[i] == 'E'))
+						++i;
+					float x = std::stof(json.substr(numStart, i - numStart));
+					skipWhitespace(json, i);
+					if (i >= json.size() || json[i] != ',')
+						return false;
+					++i;
+					skipWhitespace(json, i);
+					// parse y
+					numStart = i;
+					while (i < json.size() && (std::isdigit(static_cast<unsigned char>(json[i])) || json[i] == '-' || json[i] == '+' || json[i] == '.' || json[i] == 'e' || json[i] == 'E'))
+						++i;
+					float y = std::stof(json.substr(numStart, i - numStart));
+					skipWhitespace(json, i);
+					if (i >= json.size() || json[i] != ']')
+						return false;
+					++i; // end point
+					ownedPoints.emplace_back(x, y);
+					skipWhitespace(json, i);
+					if (json[i] == ',')
+					{
+						++i;
+						continue;
+					}
+				}
+			}
+			else
+			{
+				// skip value for other keys
+				// naive skip: if starts with '"', read string; '[' or '{' skip balanced; else read token
+				if (i < json.size() && json[i] == '"')
+				{
+					++i;
+					while (i < json.size() && json[i] != '"')
+						++i;
+					if (i < json.size())
+						++i;
+				}
+				else if (i < json.size() && (json[i] == '[' || json[i] == '{'))
+				{
+					char open = json[i];
+					char close = (open == '[') ? ']' : '}';
+					++i;
+					int depth = 1;
+					while (i < json.size() && depth > 0)
+					{
+						if (json[i] == open)
+							++depth;
+						else if (json[i] == close)
+							--depth;
+						++i;
+					}
+				}
+				else
+				{
+					while (i < json.size() && json[i] != ',' && json[i] != '}')
+						++i;
+				}
+			}
+			skipWhitespace(json, i);
+			if (i < json.size() && json[i] == ',')
+			{
+				++i;
+			}
+			continue;
+		}
+		++i;
+	}
+
+	if (ownedPoints.size() < 2)
+		return false;
+
+	points = ownedPoints.data();
+	numPoints = static_cast<int>(ownedPoints.size());
+	numSegments = numPoints / 2;
+	buildSamples();
+
+	return true;
+}
+
+void TrackData::buildSamples()
+{
+	int count = numSegments * TRACK_SAMPLES_PER_SEGMENT;
+	ownedSamples.clear();
+	ownedSamples.reserve(count);
+
+	float distance = 0.0f;
+	for (int i = 0; i < count; ++i)
+	{
+		float t = static_cast<float>(i) / static_cast<float>(TRACK_SAMPLES_PER_SEGMENT);
+
+		TrackSample sample;
+		sample.position = getPosition(t);
+		sample.normal = getNormal(t);
+		if (!ownedSamples.empty())
+			distance += glm::distance(ownedSamples.back().position, sample.position);
+		sample.distance = distance;
+		ownedSamples.push_back(sample);
+	}
+
+	samples = ownedSamples.data();
+	numSamples = count;
+}
+
+bool TrackData::loadCompiled(const char *path)
+{
+	if (!path || !mapping.open(path))
+		return false;
+
+	const char *base = static_cast<const char *>(mapping.getData());
+	size_t size = mapping.getSize();
+
+	CompiledTrackHeader header;
+	if (size < sizeof(header))
+	{
+		mapping.close();
+		return false;
+	}
+	std::memcpy(&header, base, sizeof(header));
+
+	bool valid = std::memcmp(header.magic, COMPILED_TRACK_MAGIC, sizeof(header.magic)) == 0
+		&& header.version == COMPILED_TRACK_VERSION
+		&& header.numPoints >= 2
+		&& header.numSamples == (header.numPoints / 2) * TRACK_SAMPLES_PER_SEGMENT
+		&& header.pointsOffset % alignof(float) == 0
+		&& header.samplesOffset % alignof(float) == 0
+		&& size >= header.pointsOffset + header.numPoints * sizeof(glm::vec2)
+		&& size >= header.samplesOffset + header.numSamples * sizeof(TrackSample);
+	if (!valid)
+	{
+		mapping.close();
+		return false;
+	}
+
+	// Point straight into the mapping; nothing is copied
+	points = reinterpret_cast<const glm::vec2 *>(base + header.pointsOffset);
+	numPoints = static_cast<int>(header.numPoints);
+	samples = reinterpret_cast<const TrackSample *>(base + header.samplesOffset);
+	numSamples = static_cast<int>(header.numSamples);
+	numSegments = numPoints / 2;
+
+	return true;
+}
+
+bool TrackData::isCurrentCompiled(const char *path)
+{
+	TrackData data;
+	return data.loadCompiled(path);
+}
+
+bool TrackData::writeCompiled(const char *path) const
+{
+	if (!path || numSegments == 0)
+		return false;
+
+	CompiledTrackHeader header;
+	std::memcpy(header.magic, COMPILED_TRACK_MAGIC, sizeof(header.magic));
+	header.version = COMPILED_TRACK_VERSION;
+	header.numPoints = static_cast<uint32_t>(numPoints);
+	header.numSamples = static_cast<uint32_t>(numSamples);
+	header.pointsOffset = sizeof(header);
+	header.samplesOffset = header.pointsOffset + header.numPoints * sizeof(glm::vec2);
+
+	std::ofstream f(path, std::ios::binary | std::ios::trunc);
+	if (!f.is_open())
+		return false;
+
+	f.write(reinterpret_cast<const char *>(&header), sizeof(header));
+	f.write(reinterpret_cast<const char *>(points), numPoints * sizeof(glm::vec2));
+	f.write(reinterpret_cast<const char *>(samples), numSamples * sizeof(TrackSample));
+
+	return f.good();
+}
+
+float TrackData::getClosestTOnSegment(int seg, const glm::vec2 &position, float &outDistSq) const
+{
+	// Get the three control points for this quadratic Bezier segment
+	glm::vec2 p0 = points[seg * 2];
+	glm::vec2 p1 = points[seg * 2 + 1];
+	glm::vec2 p2 = points[(seg * 2 + 2) % numPoints];
+
+	// Bezier curve: B(t) = (1-t)^2 * p0 + 2*(1-t)*t * p1 + t^2 * p2
+	// We want to minimize |B(t) - position|^2
+	// This is equivalent to finding where d/dt |B(t) - position|^2 = 0
+	
+	// Let Q = position
+	// B(t) = p0 + 2t(p1 - p0) + t^2(p0 - 2p1 + p2)
+	// B(t) - Q = (p0 - Q) + 2t(p1 - p0) + t^2(p0 - 2p1 + p2)
+	
+	// |B(t) - Q|^2 = dot(B(t) - Q, B(t) - Q)
+	// d/dt |B(t) - Q|^2 = 2 * dot(B(t) - Q, B'(t))
+	
+	// B'(t) = 2(p1 - p0) + 2t(p0 - 2p1 + p2)
+	
+	// Setting derivative to zero:
+	// dot(B(t) - Q, B'(t)) = 0
+	
+	// This expands to a cubic equation in t
+	// For simplicity and robustness, we'll use iterative refinement with Newton's method
+	// starting from multiple sample points
+	
+	glm::vec2 a = p0 - 2.0f * p1 + p2;  // coefficient of t^2
+	glm::vec2 b = 2.0f * (p1 - p0);      // coefficient of t
+	glm::vec2 c = p0 - position;         // constant term (offset from position)
+	
+	// Sample initial candidates and refine with Newton's method
+	float candidates[11]; // Start, end, and 9 intermediate points
+	int numCandidates = 11;
+	for (int i = 0; i < numCandidates; ++i)
+	{
+		candidates[i] = static_cast<float>(i) / static_cast<float>(numCandidates - 1);
+	}
+	
+	float segmentClosestT = 0.0f;
+	float segmentMinDistSq = std::numeric_limits<float>::max();
+	
+	for (int i = 0; i < numCandidates; ++i)
+	{
+		float t = candidates[i];
+		
+		// Newton's method iterations to find local minimum
+		for (int iter = 0; iter < 5; ++iter)
+		{
+			// B(t) - Q = c + t*b + t^2*a
+			glm::vec2 Bt = c + t * b + t * t * a;
+			
+			// B'(t) = b + 2*t*a
+			glm::vec2 dBt = b + 2.0f * t * a;
+			
+			// f(t) = dot(B(t) - Q, B'(t))
+			float f = glm::dot(Bt, dBt);
+			
+			// f'(t) = dot(B'(t), B'(t)) + dot(B(t) - Q, B''(t))
+			// B''(t) = 2*a
+			float df = glm::dot(dBt, dBt) + glm::dot(Bt, 2.0f * a);
+			
+			// Avoid division by zero
+			if (std::abs(df) < 1e-6f)
+				break;
+			
+			// Newton's step
+			float newT = t - f / df;
+			
+			// Clamp to [0, 1]
+			newT = std::max(0.0f, std::min(1.0f, newT));
+			
+			// Check convergence
+			if (std::abs(newT - t) < 1e-6f)
+				break;
+			
+			t = newT;
+		}
+		
+		// Evaluate distance at this t
+		glm::vec2 Bt = c + t * b + t * t * a;
+		float distSq = glm::dot(Bt, Bt);
+		
+		if (distSq < segmentMinDistSq)
+		{
+			segmentMinDistSq = distSq;
+			segmentClosestT = t;
+		}
+	}
+
+	outDistSq = segmentMinDistSq;
+	return static_cast<float>(seg) + segmentClosestT;
+}
+
+float TrackData::getClosestT(const glm::vec2 &position) const
+{
+	if (numSamples == 0)
+		return 0.0f;
+
+	// Coarse pass over the centreline LUT finds the right neighbourhood, then
+	// the exact Bezier solve refines it against that segment and its neighbours
+	int closestSample = 0;
+	float minDistSq = std::numeric_limits<float>::max();
+	for (int i = 0; i < numSamples; ++i)
+	{
+		glm::vec2 offset = samples[i].position - position;
+		float distSq = glm::dot(offset, offset);
+		if (distSq < minDistSq)
+		{
+			minDistSq = distSq;
+			closestSample = i;
+		}
+	}
+
+	float sampleT = static_cast<float>(closestSample) / static_cast<float>(TRACK_SAMPLES_PER_SEGMENT);
+	return getClosestTNear(position, sampleT);
+}
+
+float TrackData::getClosestTNear(const glm::vec2 &position, float hintT) const
+{
+	float closestT = hintT;
+	float minDistSq = std::numeric_limits<float>::max();
+
+	// Only the hint's segment and its neighbours can contain the closest point
+	// after a single substep, so skip the full-track search
+	int hintSegment = static_cast<int>(std::floor(hintT));
+	for (int offset = -1; offset <= 1; ++offset)
+	{
+		int seg = ((hintSegment + offset) % numSegments + numSegments) % numSegments;
+
+		float segmentMinDistSq;
+		float t = getClosestTOnSegment(seg, position, segmentMinDistSq);
+
+		if (segmentMinDistSq < minDistSq)
+		{
+			minDistSq = segmentMinDistSq;
+			closestT = t;
+		}
+	}
+
+	return closestT;
+}
+
+float TrackData::getLength() const
+{
+	// Distances run up to the last sample; close the loop back to the first
+	const TrackSample &last = samples[numSamples - 1];
+	return last.distance + glm::distance(last.position, samples[0].position);
+}
+
+int TrackData::getSampleIndex(float t) const
+{
+	int index = static_cast<int>(std::floor(t * TRACK_SAMPLES_PER_SEGMENT));
+	return (index % numSamples + numSamples) % numSamples;
+}
+
+float TrackData::advanceByDistance(float t, float distance) const
+{
+	int index = getSampleIndex(t);
+	float sampleT = static_cast<float>(index) / TRACK_SAMPLES_PER_SEGMENT;
+
+	// Measure from the start of t's interval, assuming uniform speed within it
+	int next = (index + 1) % numSamples;
+	float intervalLength = glm::distance(samples[index].position, samples[next].position);
+	float remaining = distance + (t - sampleT) * TRACK_SAMPLES_PER_SEGMENT * intervalLength;
+
+	// Whole laps add nothing
+	float length = getLength();
+	if (remaining >= length)
+		remaining = std::fmod(remaining, length);
+
+	for (int steps = 0; steps < numSamples; ++steps)
+	{
+		next = (index + 1) % numSamples;
+		intervalLength = glm::distance(samples[index].position, samples[next].position);
+		if (remaining < intervalLength || intervalLength <= 0.0f)
+			break;
+		remaining -= intervalLength;
+		sampleT += 1.0f / TRACK_SAMPLES_PER_SEGMENT;
+		index = next;
+	}
+
+	float fraction = intervalLength > 0.0f ? remaining / intervalLength : 0.0f;
+	float result = sampleT + fraction / TRACK_SAMPLES_PER_SEGMENT;
+	return std::fmod(result, static_cast<float>(numSegments));
+}
+
+float TrackData::getCurvature(float t) const
+{
+	int index = getSampleIndex(t);
+	const TrackSample &a = samples[index];
+	const TrackSample &b = samples[(index + 1) % numSamples];
+
+	float ds = glm::distance(a.position, b.position);
+	if (ds <= 0.0f)
+		return 0.0f;
+
+	// Turning angle of the normal over the interval
+	float angle = std::atan2(a.normal.x * b.normal.y - a.normal.y * b.normal.x, glm::dot(a.normal, b.normal));
+	return angle / ds;
+}
+
+std::vector<glm::vec3> TrackData::getWaypoints(float currentT, int numWaypoints, float waypointSpacing) const
+{
+	std::vector<glm::vec3> waypoints;
+	waypoints.reserve(numWaypoints * 2);
+
+	const float halfWidth = TRACK_WIDTH / 2.0f;
+
+	for (int i = 0; i < numWaypoints; ++i)
+	{
+		float t = currentT + static_cast<float>(i) * waypointSpacing;
+		
+		// Wrap around track
+		while (t >= static_cast<float>(numSegments))
+			t -= static_cast<float>(numSegments);
+		while (t < 0.0f)
+			t += static_cast<float>(numSegments);
+
+		glm::vec2 centerPos = getPosition(t);
+		glm::vec2 normal = getNormal(t);
+
+		// Left side of track
+		glm::vec2 leftPos = centerPos + normal * halfWidth;
+		waypoints.emplace_back(leftPos.x, 0.0f, leftPos.y);
+
+		// Right side of track
+		glm::vec2 rightPos = centerPos - normal * halfWidth;
+		waypoints.emplace_back(rightPos.x, 0.0f, rightPos.y);
+	}
+
+	return waypoints;
+}
\ No newline at end of file
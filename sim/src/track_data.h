@@ -0,0 +1,78 @@
+#ifndef TRACK_DATA_H
+
+#define TRACK_DATA_H
+
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+#include "mapped_file.h"
+
+const float TRACK_WIDTH = 12.0f; // in meters
+const int TRACK_SAMPLES_PER_SEGMENT = 20; // Resolution of the precomputed centreline LUT
+
+// Precomputed centreline sample, stored verbatim in compiled track files
+struct TrackSample
+{
+    glm::vec2 position;
+    glm::vec2 normal;
+    float distance; // Arc length from t = 0 in metres
+};
+
+// Immutable track geometry and derived tables. Instances are only handed out
+// as shared_ptr<const TrackData>, so any number of contexts can reference one
+// copy without synchronisation.
+class TrackData {
+    // Backing storage: either parsed from JSON into owned vectors, or a
+    // read-only mapping of a compiled track shared between processes
+    std::vector<glm::vec2> ownedPoints;
+    std::vector<TrackSample> ownedSamples;
+    MappedFile mapping;
+
+    const glm::vec2* points;
+    int numPoints;
+    const TrackSample* samples;
+    int numSamples;
+    int numSegments;
+
+    TrackData();
+
+    bool loadPointsFromFile(const char* path);
+    bool loadCompiled(const char* path);
+    void buildSamples();
+    float getClosestTOnSegment(int seg, const glm::vec2& position, float& outDistSq) const;
+
+public:
+    TrackData(const TrackData&) = delete;
+    TrackData& operator=(const TrackData&) = delete;
+
+    // Load a private copy of a JSON or compiled track; nullptr on failure
+    static std::shared_ptr<const TrackData> load(const char* path);
+    // As load, but returns the instance already loaded from the same path in
+    // this process if one is still alive
+    static std::shared_ptr<const TrackData> loadShared(const char* path);
+
+    bool writeCompiled(const char* path) const;
+    // Whether path is a compiled track in the format this build writes
+    static bool isCurrentCompiled(const char* path);
+
+    glm::vec2 getPosition(float t) const;
+    glm::vec2 getTangent(float t) const;
+    glm::vec2 getNormal(float t) const;
+    float getClosestT(const glm::vec2& position) const;
+    float getClosestTNear(const glm::vec2& position, float hintT) const;
+    std::vector<glm::vec3> getWaypoints(float currentT, int numWaypoints, float waypointSpacing) const;
+    int getNumSegments() const { return numSegments; }
+
+    // Arc-length queries on the centreline LUT
+    float getLength() const;
+    // Track parameter reached by travelling distance metres forward from t, wrapped
+    float advanceByDistance(float t, float distance) const;
+    // Signed curvature (1/m, positive turning towards the normal) of the LUT interval containing t
+    float getCurvature(float t) const;
+    // LUT interval containing t, in [0, getNumSamples())
+    int getSampleIndex(float t) const;
+    int getNumSamples() const { return numSamples; }
+    const TrackSample& getSample(int index) const { return samples[index]; }
+};
+
+#endif // TRACK_DATA_H
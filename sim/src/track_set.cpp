@@ -0,0 +1,121 @@
+#include "track_set.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <map>
+#include <utility>
+
+// SplitMix64 finaliser: turns consecutive seeds into uncorrelated values
+static uint64_t mixSeed(uint64_t x)
+{
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+TrackSet* TrackSet::loadDirectory(const char* path)
+{
+    namespace fs = std::filesystem;
+
+    if (!path)
+        return nullptr;
+
+    std::error_code ec;
+    fs::directory_iterator it(path, ec);
+    if (ec)
+    {
+        std::cerr << "Cannot open track directory: " << path << std::endl;
+        return nullptr;
+    }
+
+    // Sorted by name so indices are stable across processes
+    std::map<std::string, fs::path> files;
+    for (const auto& entry : it)
+    {
+        if (!entry.is_regular_file(ec))
+            continue;
+
+        const fs::path& file = entry.path();
+        std::string extension = file.extension().string();
+        std::string name = file.stem().string();
+        if (extension == ".rgt")
+            files[name] = file;
+        else if (extension == ".json" && files.find(name) == files.end())
+            files[name] = file;
+    }
+
+    std::vector<std::string> names;
+    std::vector<std::string> paths;
+    for (const auto& file : files)
+    {
+        names.push_back(file.first);
+        paths.push_back(file.second.string());
+    }
+
+    std::vector<std::shared_ptr<const TrackData>> loaded(paths.size());
+    ThreadPool::global().parallelFor(static_cast<int>(paths.size()), [&](int i) {
+        loaded[i] = TrackData::loadShared(paths[i].c_str());
+    });
+
+    // Skipping a bad track would shift every later index and misalign per-track weights
+    bool failed = false;
+    for (size_t i = 0; i < loaded.size(); ++i)
+    {
+        if (!loaded[i])
+        {
+            std::cerr << "Track failed to load: " << paths[i] << std::endl;
+            failed = true;
+        }
+    }
+    if (failed)
+    {
+        std::cerr << "Not loading track set: " << path << std::endl;
+        return nullptr;
+    }
+    if (loaded.empty())
+    {
+        std::cerr << "No tracks found in: " << path << std::endl;
+        return nullptr;
+    }
+
+    TrackSet* set = new TrackSet();
+    set->tracks = std::move(loaded);
+    set->names = std::move(names);
+    return set;
+}
+
+int TrackSet::sample(uint64_t seed, const float* weights) const
+{
+    // Top 24 bits give a uniform float in [0, 1)
+    float u = static_cast<float>(mixSeed(seed) >> 40) / static_cast<float>(1 << 24);
+
+    if (!weights)
+        return std::min(static_cast<int>(u * static_cast<float>(size())), size() - 1);
+
+    float total = 0.0f;
+    for (int i = 0; i < size(); ++i)
+    {
+        total += std::max(weights[i], 0.0f);
+    }
+    if (total <= 0.0f)
+        return std::min(static_cast<int>(u * static_cast<float>(size())), size() - 1);
+
+    float target = u * total;
+    float cumulative = 0.0f;
+    for (int i = 0; i < size(); ++i)
+    {
+        cumulative += std::max(weights[i], 0.0f);
+        if (target < cumulative)
+            return i;
+    }
+
+    // Rounding left target at the very top; return the last weighted track
+    for (int i = size() - 1; i > 0; --i)
+    {
+        if (weights[i] > 0.0f)
+            return i;
+    }
+    return 0;
+}
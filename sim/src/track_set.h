@@ -0,0 +1,33 @@
+#ifndef TRACK_SET_H
+
+#define TRACK_SET_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "track_data.h"
+
+// A collection of tracks loaded once and shared by every context that
+// selects from it. Selecting a track only swaps a shared_ptr.
+class TrackSet
+{
+public:
+    // Load every *.json and *.rgt track in a directory, in parallel.
+    // Compiled tracks win over JSON tracks with the same name.
+    static TrackSet* loadDirectory(const char* path);
+
+    int size() const { return static_cast<int>(tracks.size()); }
+    const std::shared_ptr<const TrackData>& get(int index) const { return tracks[index]; }
+    const std::string& getName(int index) const { return names[index]; }
+
+    // Deterministically pick an index from a seed. Weights, if given, must
+    // hold size() non-negative values; otherwise the choice is uniform.
+    int sample(uint64_t seed, const float* weights) const;
+
+private:
+    std::vector<std::shared_ptr<const TrackData>> tracks;
+    std::vector<std::string> names;
+};
+
+#endif // TRACK_SET_H
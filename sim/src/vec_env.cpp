@@ -0,0 +1,348 @@
+#include "vec_env.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <utility>
+#include <vector>
+#include <glm/glm.hpp>
+#include "observation.h"
+#include "philox.h"
+#include "sim_context.h"
+#include "task_graph.h"
+#include "thread_pool.h"
+#include "track.h"
+#include "track_set.h"
+#include "vehicle.h"
+
+// Matches racegym/env.py
+static const float OFF_TRACK_PENALTY_GAIN = 0.3f; // Per m/s of velocity along the track normal
+static const float CRASH_PENALTY = 10.0f;
+static const float STEP_SECONDS = SUBSTEP_DELTA * SUBSTEPS_PER_STEP;
+
+VecEnv::VecEnv(const TrackSet* trackSet, int numEnvs, bool fixedStart, int maxEpisodeSteps)
+    : trackSet(trackSet), seed(0), fixedStart(fixedStart), maxEpisodeSteps(maxEpisodeSteps), autoReset(true), faultReset(true),
+      envs(numEnvs), buffers() {
+    // Contexts are created, reset and stepped with the same static split over the pool,
+    // so each one's memory is first touched by (and local to) the thread that steps it
+    ThreadPool::global().parallelForStatic(numEnvs, [this](int i) {
+        Env& env = envs[i];
+        env.ctx = new SimContext();
+        env.vehicle = nullptr;
+        env.episode = 0;
+        env.trackLength = 0.0f;
+        env.lastProgress = 0.0f;
+        env.lapStartTime = std::numeric_limits<float>::quiet_NaN();
+        env.maxLapIndex = 0.0f;
+        env.steps = 0;
+        env.episodeReturn = 0.0;
+        env.startProgress = 0.0f;
+        env.waiting = false;
+        env.faulted = false;
+        env.episodeFinished = false;
+    });
+
+    // Default histogram ranges suit tracks of a few dozen segments
+    stats.episodeReturn.setRange(-20.0f, 100.0f);
+    stats.episodeLength.setRange(0.0f, static_cast<float>(maxEpisodeSteps));
+    stats.episodeDistance.setRange(0.0f, 100.0f);
+    stats.lapTime.setRange(0.0f, 300.0f);
+    stats.clear();
+}
+
+VecEnv::~VecEnv() {
+    for (Env& env : envs) {
+        delete env.ctx;
+    }
+}
+
+void VecEnv::reset(uint64_t seed) {
+    this->seed = seed;
+    for (Env& env : envs) {
+        env.episode = 0;
+    }
+
+    ThreadPool::global().parallelForStatic(size(), [this](int i) {
+        resetEnv(i);
+    });
+
+    activeEnvs.resize(size());
+    for (int i = 0; i < size(); ++i) {
+        activeEnvs[i] = i;
+    }
+    newlyWaiting.clear();
+    faultedEnvs.clear();
+}
+
+int VecEnv::resetFinished() {
+    std::vector<int> finished;
+    for (int i = 0; i < size(); ++i) {
+        if (envs[i].waiting) {
+            finished.push_back(i);
+        }
+    }
+
+    // Equal shares of the finished envs, in index order, so each thread resets roughly
+    // the envs it stepped
+    ThreadPool& pool = ThreadPool::global();
+    pool.parallelForStatic(finished.empty() ? 0 : pool.getNumThreads(), [this, &finished, &pool](int part) {
+        int first, last;
+        pool.getStaticBlock(static_cast<int>(finished.size()), part, first, last);
+        for (int i = first; i < last; ++i) {
+            resetEnv(finished[i]);
+        }
+    });
+
+    if (!finished.empty()) {
+        std::vector<int> merged(activeEnvs.size() + finished.size());
+        std::merge(activeEnvs.begin(), activeEnvs.end(), finished.begin(), finished.end(), merged.begin());
+        activeEnvs.swap(merged);
+    }
+    return static_cast<int>(finished.size());
+}
+
+void VecEnv::resetEnv(int index) {
+    Env& env = envs[index];
+    if (env.vehicle) {
+        env.ctx->removeVehicle(env.vehicle);
+        env.vehicle = nullptr;
+    }
+
+    RandomStream random(seed, static_cast<uint32_t>(index), env.episode++, 0);
+    int trackIndex = trackSet->sample(random.nextUint64(), nullptr);
+    env.ctx->setTrack(trackSet->get(trackIndex));
+    env.trackLength = static_cast<float>(env.ctx->track->getNumSegments());
+
+    float spawnT;
+    if (fixedStart) {
+        spawnT = env.trackLength - 2.0f;
+    } else {
+        spawnT = random.uniform(0.0f, env.trackLength);
+    }
+    env.vehicle = env.ctx->addVehicle(spawnT);
+    env.lastProgress = static_cast<float>(env.vehicle->trackProgress);
+    env.startProgress = env.lastProgress;
+    env.episodeReturn = 0.0;
+    env.lapStartTime = std::numeric_limits<float>::quiet_NaN();
+    env.maxLapIndex = std::floor(env.lastProgress / env.trackLength);
+    env.steps = 0;
+    env.waiting = false;
+
+    if (buffers.observations) {
+        computeObservation(*env.ctx->track, *env.vehicle,
+                           buffers.observations + static_cast<size_t>(index) * OBSERVATION_SIZE, OBSERVATION_SIZE);
+    }
+}
+
+void VecEnv::applyActions() {
+    clearWaitingRows();
+    for (int i : activeEnvs) {
+        const float* action = buffers.actions + static_cast<size_t>(i) * VEC_ENV_ACTION_SIZE;
+        envs[i].vehicle->setSteerAmount(action[0]);
+        envs[i].vehicle->setThrottle(action[1]);
+        envs[i].vehicle->setBrake(-action[1]);
+    }
+}
+
+void VecEnv::finishStep(int index) {
+    Env& env = envs[index];
+    if (!env.ctx->physicsWorld.isStateValid()) {
+        faultStep(index);
+        return;
+    }
+
+    Vehicle* vehicle = env.vehicle;
+    const Track* track = env.ctx->track;
+
+    float progress = static_cast<float>(vehicle->trackProgress);
+    float delta = progress - env.lastProgress;
+
+    // Lap time runs between consecutive start line crossings, interpolated within the step.
+    // Only the first forward crossing into each lap counts, so backing over the line and
+    // driving across it again isn't a lap.
+    float lapTime = std::numeric_limits<float>::quiet_NaN();
+    float lapIndex = std::floor(progress / env.trackLength);
+    if (lapIndex > env.maxLapIndex) {
+        env.maxLapIndex = lapIndex;
+        float crossTime = (env.steps + (lapIndex * env.trackLength - env.lastProgress) / delta) * STEP_SECONDS;
+        if (!std::isnan(env.lapStartTime)) {
+            lapTime = crossTime - env.lapStartTime;
+        }
+        env.lapStartTime = crossTime;
+    }
+    env.steps++;
+    env.lastProgress = progress;
+
+    float reward = delta;
+    bool terminated = false;
+    if (vehicle->isOffTrack(env.ctx->track)) {
+        terminated = true;
+        // Penalise the velocity component carrying the car away from the track
+        glm::vec2 normal = track->getNormal(vehicle->trackT);
+        glm::vec3 velocity = vehicle->body->velocity;
+        reward -= std::abs(velocity.x * normal.x + velocity.z * normal.y) * OFF_TRACK_PENALTY_GAIN;
+    }
+    if (isCrashed(vehicle->body->position, vehicle->body->orientation, track)) {
+        terminated = true;
+        reward -= CRASH_PENALTY;
+    }
+    bool truncated = env.steps >= maxEpisodeSteps;
+    env.episodeReturn += reward;
+
+    buffers.rewards[index] = reward;
+    buffers.terminated[index] = terminated ? 1 : 0;
+    buffers.truncated[index] = truncated ? 1 : 0;
+    buffers.lapTimes[index] = lapTime;
+
+    float* observation = buffers.observations + static_cast<size_t>(index) * OBSERVATION_SIZE;
+    computeObservation(*track, *vehicle, observation, OBSERVATION_SIZE);
+    if (terminated || truncated) {
+        env.episodeFinished = true;
+        env.finishedTerminated = terminated;
+        env.finishedReturn = static_cast<float>(env.episodeReturn);
+        env.finishedDistance = progress - env.startProgress;
+        env.finishedLength = env.steps;
+        if (buffers.terminalObservations) {
+            std::memcpy(buffers.terminalObservations + static_cast<size_t>(index) * OBSERVATION_SIZE,
+                        observation, sizeof(float) * OBSERVATION_SIZE);
+        }
+        if (autoReset) {
+            resetEnv(index);
+        } else {
+            env.waiting = true;
+        }
+    }
+}
+
+void VecEnv::faultStep(int index) {
+    Env& env = envs[index];
+    env.faulted = true;
+    buffers.rewards[index] = 0.0f;
+    buffers.terminated[index] = 0;
+    buffers.truncated[index] = 1;
+    buffers.lapTimes[index] = std::numeric_limits<float>::quiet_NaN();
+
+    // The row still holds the observation of the last step, before the state diverged
+    if (buffers.terminalObservations) {
+        std::memcpy(buffers.terminalObservations + static_cast<size_t>(index) * OBSERVATION_SIZE,
+                    buffers.observations + static_cast<size_t>(index) * OBSERVATION_SIZE,
+                    sizeof(float) * OBSERVATION_SIZE);
+    }
+    if (autoReset && faultReset) {
+        resetEnv(index);
+    } else {
+        env.waiting = true;
+    }
+}
+
+void VecEnv::stepBatch(VecEnv* const* vecEnvs, int count) {
+    std::vector<SimContext*> contexts;
+    for (int v = 0; v < count; ++v) {
+        for (int i : vecEnvs[v]->activeEnvs) {
+            contexts.push_back(vecEnvs[v]->envs[i].ctx);
+        }
+    }
+    const int numEnvs = static_cast<int>(contexts.size());
+
+    // Physics and observations give thread p block p of every VecEnv's active envs, so
+    // threads get equal counts however the inactive envs bunch up. The active list is
+    // sorted, so while every env is active the blocks are exactly the constructor's and
+    // each env is stepped by the thread its memory is local to; otherwise they shift
+    // only as far as needed to stay balanced.
+    ThreadPool& pool = ThreadPool::global();
+    auto forActiveInBlock = [vecEnvs, count, &pool](int part, auto&& fn) {
+        for (int v = 0; v < count; ++v) {
+            VecEnv* vecEnv = vecEnvs[v];
+            const std::vector<int>& active = vecEnv->activeEnvs;
+            int first, last;
+            pool.getStaticBlock(static_cast<int>(active.size()), part, first, last);
+            for (int i = first; i < last; ++i) {
+                fn(vecEnv, active[i]);
+            }
+        }
+    };
+
+    // Actions -> policies -> physics -> observations and rewards -> statistics. Every
+    // phase writes only its own env's (or VecEnv's) data, so results match a serial run.
+    TaskGraph graph;
+    int actions = graph.addTask(count, [vecEnvs](int v) {
+        vecEnvs[v]->applyActions();
+    });
+    int policies = graph.addTask(1, [&contexts, numEnvs](int) {
+        applyPolicies(contexts.data(), numEnvs);
+    });
+    int physics = graph.addTask(pool.getNumThreads(), [&forActiveInBlock](int part) {
+        forActiveInBlock(part, [](VecEnv* vecEnv, int i) {
+            vecEnv->envs[i].ctx->stepPhysics();
+        });
+    }, true);
+    int finish = graph.addTask(pool.getNumThreads(), [&forActiveInBlock](int part) {
+        forActiveInBlock(part, [](VecEnv* vecEnv, int i) {
+            vecEnv->finishStep(i);
+        });
+    }, true);
+    int record = graph.addTask(count, [vecEnvs](int v) {
+        vecEnvs[v]->recordStats();
+    });
+    graph.addDependency(actions, policies);
+    graph.addDependency(policies, physics);
+    graph.addDependency(physics, finish);
+    graph.addDependency(finish, record);
+    graph.run(pool);
+}
+
+void VecEnv::recordStats() {
+    stats.steps += activeEnvs.size();
+    faultedEnvs.clear();
+    for (int i : activeEnvs) {
+        if (!std::isnan(buffers.lapTimes[i])) {
+            stats.lapTime.add(buffers.lapTimes[i]);
+        }
+
+        Env& env = envs[i];
+        if (env.faulted) {
+            env.faulted = false;
+            stats.faulted++;
+            faultedEnvs.push_back(i);
+            if (env.waiting) {
+                newlyWaiting.push_back(i);
+            }
+            continue;
+        }
+        if (!env.episodeFinished) {
+            continue;
+        }
+        env.episodeFinished = false;
+        stats.episodes++;
+        if (env.finishedTerminated) {
+            stats.terminated++;
+        } else {
+            stats.truncated++;
+        }
+        stats.episodeReturn.add(env.finishedReturn);
+        stats.episodeLength.add(static_cast<float>(env.finishedLength));
+        stats.episodeDistance.add(env.finishedDistance);
+        if (env.waiting) {
+            newlyWaiting.push_back(i);
+        }
+    }
+
+    if (!newlyWaiting.empty()) {
+        activeEnvs.erase(std::remove_if(activeEnvs.begin(), activeEnvs.end(),
+                                        [this](int i) { return envs[i].waiting; }),
+                         activeEnvs.end());
+    }
+}
+
+void VecEnv::clearWaitingRows() {
+    for (int i : newlyWaiting) {
+        if (!envs[i].waiting) {
+            continue; // Reset in the meantime; this step overwrites the row
+        }
+        buffers.rewards[i] = 0.0f;
+        buffers.terminated[i] = 0;
+        buffers.truncated[i] = 0;
+        buffers.lapTimes[i] = std::numeric_limits<float>::quiet_NaN();
+    }
+    newlyWaiting.clear();
+}
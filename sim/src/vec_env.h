@@ -0,0 +1,121 @@
+#ifndef VEC_ENV_H
+#define VEC_ENV_H
+
+#include <cstdint>
+#include <vector>
+#include "cache_line.h"
+#include "episode_stats.h"
+
+class TrackSet;
+class Vehicle;
+struct SimContext;
+
+const int VEC_ENV_ACTION_SIZE = 2; // steer, throttle (negative throttle brakes)
+
+// Caller-owned arrays a VecEnv reads actions from and writes results to, one row per env.
+// They can live anywhere, e.g. in shared memory mapped by a client process.
+struct VecEnvBuffers {
+    const float* actions;         // [numEnvs][VEC_ENV_ACTION_SIZE]
+    float* observations;          // [numEnvs][OBSERVATION_SIZE], after any automatic reset
+    float* rewards;               // [numEnvs]
+    uint8_t* terminated;          // [numEnvs] off track or crashed
+    uint8_t* truncated;           // [numEnvs] hit maxEpisodeSteps
+    float* lapTimes;              // [numEnvs] lap completed this step in seconds, NaN otherwise
+    float* terminalObservations;  // [numEnvs][OBSERVATION_SIZE] last observation of a finished episode
+};
+
+// A batch of RaceGymEnv-equivalent environments, one context and vehicle each, with the
+// episode logic (reward, termination, lap timing) of racegym/env.py done natively.
+// Finished episodes reset automatically, like a stable-baselines3 VecEnv, and are
+// aggregated into EpisodeStats instead of per-episode records.
+//
+// With automatic resets off, a finished env instead waits for resetFinished(). Steps
+// only visit the compact list of active envs, so waiting envs cost nothing; their
+// rows read reward 0, not terminated or truncated and no lap from the next step on.
+//
+// After every step each env's body state is checked for NaN, infinity and runaway
+// values. A faulted env ends its episode as truncated, with reward 0 and its last
+// finite observation as the terminal one. It is counted in EpisodeStats::faulted
+// instead of as an episode, and reset like a finished env or, with fault resets
+// off, quarantined until resetFinished().
+class VecEnv {
+public:
+    // The track set must outlive the VecEnv
+    VecEnv(const TrackSet* trackSet, int numEnvs, bool fixedStart, int maxEpisodeSteps);
+    ~VecEnv();
+
+    VecEnv(const VecEnv&) = delete;
+    VecEnv& operator=(const VecEnv&) = delete;
+
+    int size() const { return static_cast<int>(envs.size()); }
+    void setBuffers(const VecEnvBuffers& buffers) { this->buffers = buffers; }
+
+    // Start a new episode in every env and write the observations. Each episode draws
+    // its track and spawn point from the RandomStream (seed, env index, episode, 0),
+    // counting episodes from this reset, so draws are reproducible whatever thread
+    // resets an env.
+    void reset(uint64_t seed);
+
+    void setAutoReset(bool enabled) { autoReset = enabled; }
+    // With fault resets off, faulted envs wait for resetFinished() even when finished
+    // episodes reset automatically
+    void setFaultReset(bool enabled) { faultReset = enabled; }
+    // Ascending indices of the envs that faulted in the last step
+    const std::vector<int>& getFaultedEnvs() const { return faultedEnvs; }
+    // Start a new episode in every env waiting for one and write their observations;
+    // returns how many were reset
+    int resetFinished();
+    int getActiveCount() const { return static_cast<int>(activeEnvs.size()); }
+
+    // Apply the actions of every active env in every VecEnv, step all contexts together on the
+    // global pool and write the results into each VecEnv's buffers
+    static void stepBatch(VecEnv* const* vecEnvs, int count);
+
+    // Episodes finished since creation or the last clearStats(); histogram ranges can be
+    // changed through the summaries' setRange
+    EpisodeStats& getStats() { return stats; }
+    void clearStats() { stats.clear(); }
+
+private:
+    struct alignas(CACHE_LINE_SIZE) Env {
+        SimContext* ctx;
+        Vehicle* vehicle;
+        uint32_t episode; // Episodes started since the last reset(seed)
+        float trackLength;
+        float lastProgress;
+        float lapStartTime; // NaN until the first start line crossing
+        float maxLapIndex;  // Highest lap index reached this episode; only new maxima count as laps
+        int steps;
+        double episodeReturn;
+        float startProgress;
+        bool waiting;         // Finished without automatic reset; not in activeEnvs
+        bool faulted;         // Set by faultStep, consumed by recordStats
+        bool episodeFinished; // Set by finishStep with the totals below, consumed by recordStats
+        bool finishedTerminated;
+        float finishedReturn;
+        float finishedDistance;
+        int finishedLength;
+    };
+
+    void resetEnv(int index);
+    void applyActions();
+    void finishStep(int index);
+    void faultStep(int index);
+    void recordStats();
+    void clearWaitingRows();
+
+    const TrackSet* trackSet;
+    uint64_t seed;
+    bool fixedStart;
+    int maxEpisodeSteps;
+    bool autoReset;
+    bool faultReset;
+    std::vector<Env> envs;
+    std::vector<int> activeEnvs;  // Ascending indices of envs that are stepped
+    std::vector<int> newlyWaiting; // Finished last step; their rows are cleared on the next
+    std::vector<int> faultedEnvs;
+    VecEnvBuffers buffers;
+    EpisodeStats stats;
+};
+
+#endif // VEC_ENV_H
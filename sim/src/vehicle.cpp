@@ -1,20 +1,19 @@
 #include "vehicle.h"
 #include "track.h"
+#include "expert_driver.h"
+#include "vehicle_dynamics.h"
 
-#include <glad/glad.h>
 #include <glm/glm.hpp>
-#include <glm/gtc/matrix_transform.hpp>
-#include <glm/gtc/type_ptr.hpp>
 #include <iostream>
 #include <algorithm>
 
 Vehicle::Vehicle(PhysicsWorld &world, const glm::vec3 &position, const glm::vec3 &rotation)
     : world(world)
 {
-    CollisionShape* boxShape = new BoxShape(VEHICLE_DIMENSIONS / 2.0f); // Example dimensions
+    shape = world.getArena().create<BoxShape>(VEHICLE_DIMENSIONS / 2.0f); // Example dimensions
     // Convert Euler angles to quaternion: rotation is assumed to be (pitch, yaw, roll)
     glm::quat orientation = glm::quat(glm::vec3(rotation.x, rotation.y, rotation.z));
-    body = world.addBody(boxShape, VEHICLE_MASS, position, orientation);
+    body = world.addBody(shape, VEHICLE_MASS, position, orientation);
 
     std::vector<glm::vec3> wheelPositions = {
         glm::vec3(+VEHICLE_DIMENSIONS.x * 0.5f, WHEEL_RADIUS - VEHICLE_DIMENSIONS.y * 0.5f, +VEHICLE_DIMENSIONS.z * 0.5f),  // Front-Right
@@ -42,292 +41,64 @@ Vehicle::Vehicle(PhysicsWorld &world, const glm::vec3 &position, const glm::vec3
     throttle = 0.0f;
     brake = 0.0f;
 
-    // Create a simple box for rendering (only if graphics are enabled)
-    if (Renderer::is_initialized())
-    {
-        float w = VEHICLE_DIMENSIONS.x;
-        float h = VEHICLE_DIMENSIONS.y;
-        float l = VEHICLE_DIMENSIONS.z;
-        float vertices[] = {
-            -w/2, -h/2, -l/2,
-             w/2, -h/2, -l/2,
-             w/2,  h/2, -l/2,
-            -w/2,  h/2, -l/2,
-            -w/2, -h/2,  l/2,
-             w/2, -h/2,  l/2,
-             w/2,  h/2,  l/2,
-            -w/2,  h/2,  l/2,
-        };
-        unsigned int indices[] = {
-            0, 1, 2, 2, 3, 0,
-            4, 5, 6, 6, 7, 4,
-            0, 1, 5, 5, 4, 0,
-            2, 3, 7, 7, 6, 2,
-            0, 3, 7, 7, 4, 0,
-            1, 2, 6, 6, 5, 1,
-        };
-        chassisMesh = Renderer::createMesh(vertices, 8, indices, 36);
-
-        // Create wheel cylinder mesh
-        std::vector<float> wheelVertices;
-        std::vector<unsigned int> wheelIndices;
-        
-        float radius = WHEEL_RADIUS;
-        float thickness = WHEEL_THICKNESS;
-        
-        // Generate vertices for cylinder (two circles)
-        for (int i = 0; i < WHEEL_RENDER_RESOLUTION; ++i)
-        {
-            float angle = 2.0f * 3.14159265359f * i / WHEEL_RENDER_RESOLUTION;
-            float x = radius * glm::cos(angle);
-            float z = radius * glm::sin(angle);
-            
-            // Front circle
-            wheelVertices.push_back(x);
-            wheelVertices.push_back(-thickness / 2.0f);
-            wheelVertices.push_back(z);
-            
-            // Back circle
-            wheelVertices.push_back(x);
-            wheelVertices.push_back(thickness / 2.0f);
-            wheelVertices.push_back(z);
-        }
-        
-        // Generate indices for cylinder sides
-        for (int i = 0; i < WHEEL_RENDER_RESOLUTION; ++i)
-        {
-            int next = (i + 1) % WHEEL_RENDER_RESOLUTION;
-            int frontCurr = i * 2;
-            int backCurr = i * 2 + 1;
-            int frontNext = next * 2;
-            int backNext = next * 2 + 1;
-            
-            // Two triangles for side face
-            wheelIndices.push_back(frontCurr);
-            wheelIndices.push_back(frontNext);
-            wheelIndices.push_back(backCurr);
-            
-            wheelIndices.push_back(backCurr);
-            wheelIndices.push_back(frontNext);
-            wheelIndices.push_back(backNext);
-        }
-        
-        // Add center vertices for caps
-        int centerFront = wheelVertices.size() / 3;
-        wheelVertices.push_back(0.0f);
-        wheelVertices.push_back(-thickness / 2.0f);
-        wheelVertices.push_back(0.0f);
-        
-        int centerBack = wheelVertices.size() / 3;
-        wheelVertices.push_back(0.0f);
-        wheelVertices.push_back(thickness / 2.0f);
-        wheelVertices.push_back(0.0f);
-        
-        // Generate indices for caps
-        for (int i = 0; i < WHEEL_RENDER_RESOLUTION; ++i)
-        {
-            int next = (i + 1) % WHEEL_RENDER_RESOLUTION;
-            
-            // Front cap
-            wheelIndices.push_back(centerFront);
-            wheelIndices.push_back(i * 2);
-            wheelIndices.push_back(next * 2);
-            
-            // Back cap
-            wheelIndices.push_back(centerBack);
-            wheelIndices.push_back(next * 2 + 1);
-            wheelIndices.push_back(i * 2 + 1);
-        }
-        wheelMesh = Renderer::createMesh(wheelVertices.data(), wheelVertices.size() / 3, wheelIndices.data(), wheelIndices.size());
-    }
+    trackT = 0.0f;
+    trackProgress = 0.0;
+
+    telemetryId = 0;
 }
 
 Vehicle::~Vehicle()
 {
-    if(Renderer::is_initialized())
-    {
-        Renderer::destroyMesh(chassisMesh);
-        Renderer::destroyMesh(wheelMesh);
-    }
-
     world.removeBody(body);
+    world.getArena().destroy(shape);
 }
 
-void Vehicle::step(float deltaTime)
+void Vehicle::step(float deltaTime, TelemetryRecord* record)
 {
-
-    // Suspension axis is local -Y; rotate to world using quaternion
-    glm::vec3 suspAxisWorld = body->orientation * glm::vec3(0.0f, -1.0f, 0.0f);
-
+    // Front wheels steer; kept on the wheels for rendering
     wheels[0].steerAngle = steerAmount * glm::radians(30.0f); // Front-Right
     wheels[1].steerAngle = steerAmount * glm::radians(30.0f); // Front-Left
     wheels[2].steerAngle = 0.0f; // Rear-Right
     wheels[3].steerAngle = 0.0f; // Rear-Left
 
-    float engineAngularVelocity = (wheels[2].angularVelocity + wheels[3].angularVelocity) / 2; // Simple average
-    float enginePower = throttle * 50000.0f; // Max 110kW
-    float engineTorque = glm::min(enginePower / glm::max(engineAngularVelocity, 1.0f), 2000.0f); // Limit max torque to 3000Nm
-    float driveTorque = engineTorque * 0.5f; // Split torque to rear wheels
-    wheels[0].driveTorque = 0.0f;
-    wheels[1].driveTorque = 0.0f;
-    wheels[2].driveTorque = driveTorque;
-    wheels[3].driveTorque = driveTorque;
-
-    float brakeTorque = brake * 3000.0f; // Max 2000Nm per wheel
-    wheels[0].brakeTorque = brakeTorque;
-    wheels[1].brakeTorque = brakeTorque;
-    wheels[2].brakeTorque = brakeTorque;
-    wheels[3].brakeTorque = brakeTorque;
-
-    for(int i = 0; i < 2; i++)
+    VehicleDynamicsState<float> state;
+    state.body = body->getBodyState();
+    for (int i = 0; i < 4; ++i)
     {
-        for(int j = 0; j < 2; j++)
-        {
-            int leftWheelIndex = i * 2 + 1;
-            int rightWheelIndex = i * 2 + 0;
-
-            float leftCompression = wheels[leftWheelIndex].compression;
-            float rightCompression = wheels[rightWheelIndex].compression;
+        state.compression[i] = wheels[i].compression;
+        state.wheelAngularVelocity[i] = wheels[i].angularVelocity;
+    }
 
-            float antiRollForce = (leftCompression - rightCompression) * ANTI_ROLL_BAR_STIFFNESS;
+    if (record)
+        *record = TelemetryRecord(); // Wheels without contact report zeros
 
-            wheels[leftWheelIndex].antiRollForce = -antiRollForce;
-            wheels[rightWheelIndex].antiRollForce = antiRollForce;
-        }
-    }
+    WheelContact contacts[4];
+    applyVehicleForces(state, wheels.data(), steerAmount, throttle, brake, deltaTime,
+                       contacts, record);
 
+    // The forces only read the kinematic state, so only the accumulators go back
+    body->setAccumulated(state.body.force.toGlm(), state.body.torque.toGlm());
     for (int i = 0; i < 4; ++i)
     {
-        // Wheel mount position in world using quaternion rotation
-        glm::vec3 mountWorld = body->position + body->orientation * (wheels[i].localPosition - glm::vec3(0.0f, wheels[i].wheelRadius, 0.0f));
-        
-        glm::vec3 suspAxisWorld = body->orientation * glm::vec3(0.0f, -1.0f, 0.0f);
-
-        float k = wheels[i].suspensionStiffness;
-
-        // Raycast to infinite plane y=0 along suspAxisWorld
-        // Solve mountWorld + suspAxisWorld * t => y = 0
-        float denom = suspAxisWorld.y;
-        if (glm::abs(denom) < 1e-4f)
-            continue; // axis parallel to ground, skip
-        float t = -mountWorld.y / denom;
-
-        if (t < 0.0f) {
-            wheels[i].hasContact = false;
-            continue; // pointing away from ground
-        }
-
-        // Limit to suspension reach
-        if (t > wheels[i].restLength) {
-            wheels[i].hasContact = false;
-            continue; // no contact within suspension
-        }
-
-        glm::vec3 contactPoint = mountWorld + suspAxisWorld * t;
-        wheels[i].lastContactPoint = contactPoint;
-        wheels[i].hasContact = true;
-
-        // Compression is how much shorter than rest the ray is
-        float compression = wheels[i].restLength - t;
-        float compressionVelocity = (compression - wheels[i].compression) / deltaTime;
-        float forceMag = k * compression + SUSPENSION_DAMPING * compressionVelocity + wheels[i].antiRollForce;
-
-        wheels[i].compression = compression;
-
-        // Ground normal for y=0 plane
-        glm::vec3 normal(0.0f, 1.0f, 0.0f);
-        glm::vec3 suspensionForce = normal * forceMag;
-
-        // Calculate tire forces using Pacejka Magic Formula
-        // Get wheel world orientation (including steer angle)
-        glm::quat steerQuat = glm::angleAxis(wheels[i].steerAngle, glm::vec3(0.0f, 1.0f, 0.0f));
-        glm::quat wheelOrientation = body->orientation * steerQuat;
-        
-        // Forward and side directions in world space
-        glm::vec3 forwardDir = wheelOrientation * glm::vec3(0.0f, 0.0f, 1.0f);
-        glm::vec3 sideDir = wheelOrientation * glm::vec3(1.0f, 0.0f, 0.0f);
-        
-        // Velocity at contact point
-        glm::vec3 r = contactPoint - body->position;
-        glm::vec3 contactVelocity = body->velocity + glm::cross(body->angularVelocity, r);
-        
-        // Project velocity onto forward and side directions
-        float forwardSpeed = glm::dot(contactVelocity, forwardDir);
-        float sideSpeed = glm::dot(contactVelocity, sideDir);
-        // Calculate slip ratio (longitudinal slip)
-        float wheelCircumSpeed = wheels[i].angularVelocity * wheels[i].wheelRadius;
-        float slipRatio = (wheelCircumSpeed - forwardSpeed) / std::max(glm::abs(forwardSpeed), 0.1f);
-        // Calculate slip angle (lateral slip)
-        float slipAngle  = glm::atan(-sideSpeed / std::max(glm::abs(forwardSpeed), 0.1f));
-        
-        // Apply Pacejka Magic Formula
-        float normalForce = forceMag;
-        float longitudinalForce = wheels[i].calculatePacejka(slipRatio, PACEJKA_LONG, normalForce);
-        float lateralForce = wheels[i].calculatePacejka(slipAngle, PACEJKA_LAT, normalForce);
-    
-        // Combine forces in world space
-        glm::vec3 tireForce = suspensionForce + forwardDir * longitudinalForce + sideDir * lateralForce;
-        
-        // Apply at contact point to induce correct torque
-        body->applyForceAtPoint(tireForce, contactPoint);
-        
-        // Update wheel angular velocity
-        // Torque on wheel = driveTorque - longitudinalForce * wheelRadius
-        float wheelTorque = wheels[i].driveTorque - longitudinalForce * wheels[i].wheelRadius;
-        float angularAcceleration = wheelTorque / wheels[i].inertia;
-        wheels[i].angularVelocity += angularAcceleration * deltaTime;
-
-        // Apply braking
-        float brakeAngularDecel = wheels[i].brakeTorque / wheels[i].inertia;
-        if(std::abs(wheels[i].angularVelocity) > brakeAngularDecel * deltaTime)
-        {
-            wheels[i].angularVelocity -= glm::sign(wheels[i].angularVelocity) * brakeAngularDecel * deltaTime;
-        }
-        else
+        wheels[i].compression = state.compression[i];
+        wheels[i].angularVelocity = state.wheelAngularVelocity[i];
+        wheels[i].hasContact = contacts[i].hasContact;
+        if (contacts[i].hasContact)
         {
-            wheels[i].angularVelocity = 0.0f;
+            wheels[i].lastContactPoint = contacts[i].point;
+            // Update roll angle for rendering
+            wheels[i].rollAngle += wheels[i].angularVelocity * deltaTime;
         }
-
-        // Update roll angle for rendering
-        wheels[i].rollAngle += wheels[i].angularVelocity * deltaTime;
     }
 
-    body->applyForce(-body->velocity * glm::length(body->velocity) * 0.4f); // Simple drag
-}
-
-void Vehicle::draw(int locModel, int locColor)
-{
-
-    if(!Renderer::is_initialized())
-        return;
-
-    glm::mat4 model = body->getModelMatrix();
-
-    Renderer::drawMesh(chassisMesh, model, glm::vec3(0.8f, 0.0f, 0.0f)); // Red color for vehicle
-
-    // Draw wheels
-    for (int i = 0; i < 4; ++i)
+    if (record)
     {
-        // Calculate wheel position in world space
-        glm::vec3 mountWorld = body->position + body->orientation * wheels[i].localPosition;
-        
-        // Apply suspension compression
-        glm::vec3 suspAxisWorld = body->orientation * glm::vec3(0.0f, -1.0f, 0.0f);
-        float currentLength = wheels[i].restLength - wheels[i].compression;
-        glm::vec3 wheelPosition = mountWorld + suspAxisWorld * currentLength;
-        
-        // Create wheel transformation matrix
-        glm::mat4 wheelModel = glm::translate(glm::mat4(1.0f), wheelPosition);
-        
-        // Apply vehicle body rotation
-        glm::mat4 bodyRotation = glm::mat4_cast(body->orientation);
-        wheelModel = wheelModel * bodyRotation;
-
-        wheelModel = glm::rotate(wheelModel, glm::radians(90.0f),  glm::vec3(0.0f, 0.0f, 1.0f));
-        wheelModel = glm::rotate(wheelModel, wheels[i].steerAngle, glm::vec3(1.0f, 0.0f, 0.0f));
-        wheelModel = glm::rotate(wheelModel, wheels[i].rollAngle,  glm::vec3(0.0f, 1.0f, 0.0f));
-
-        Renderer::drawMesh(wheelMesh, wheelModel, glm::vec3(0.0f, 0.0f, 0.0f)); // Black color for wheels
+        record->vehicleId = telemetryId;
+        record->speed = glm::length(body->velocity);
+        record->yawRate = body->angularVelocity.y;
+        record->steer = steerAmount;
+        record->throttle = throttle;
+        record->brake = brake;
     }
 }
 
@@ -346,22 +117,81 @@ void Vehicle::setBrake(float brakeInput)
     this->brake = std::clamp(brakeInput, 0.0f, 1.0f);
 }
 
+void Vehicle::getState(float* out) const
+{
+    int idx = 0;
+    out[idx++] = body->position.x;
+    out[idx++] = body->position.y;
+    out[idx++] = body->position.z;
+    out[idx++] = body->orientation.w;
+    out[idx++] = body->orientation.x;
+    out[idx++] = body->orientation.y;
+    out[idx++] = body->orientation.z;
+    out[idx++] = body->velocity.x;
+    out[idx++] = body->velocity.y;
+    out[idx++] = body->velocity.z;
+    out[idx++] = body->angularVelocity.x;
+    out[idx++] = body->angularVelocity.y;
+    out[idx++] = body->angularVelocity.z;
+    for (int i = 0; i < 4; ++i)
+        out[idx++] = wheels[i].compression;
+    for (int i = 0; i < 4; ++i)
+        out[idx++] = wheels[i].angularVelocity;
+
+    const glm::vec3& force = body->getAccumulatedForce();
+    const glm::vec3& torque = body->getAccumulatedTorque();
+    out[idx++] = force.x;
+    out[idx++] = force.y;
+    out[idx++] = force.z;
+    out[idx++] = torque.x;
+    out[idx++] = torque.y;
+    out[idx++] = torque.z;
+}
+
+void Vehicle::setState(const float* in)
+{
+    body->position = glm::vec3(in[0], in[1], in[2]);
+    body->orientation = glm::quat(in[3], in[4], in[5], in[6]);
+    body->velocity = glm::vec3(in[7], in[8], in[9]);
+    body->angularVelocity = glm::vec3(in[10], in[11], in[12]);
+
+    int idx = 13;
+    for (int i = 0; i < 4; ++i)
+        wheels[i].compression = in[idx++];
+    for (int i = 0; i < 4; ++i)
+        wheels[i].angularVelocity = in[idx++];
+
+    body->setAccumulated(glm::vec3(in[idx], in[idx + 1], in[idx + 2]),
+                         glm::vec3(in[idx + 3], in[idx + 4], in[idx + 5]));
+}
+
 bool Vehicle::isOffTrack(Track* track) const
+{
+    glm::vec3 contactPoints[4];
+    bool hasContact[4];
+    for (int i = 0; i < 4; ++i)
+    {
+        contactPoints[i] = wheels[i].lastContactPoint;
+        hasContact[i] = wheels[i].hasContact;
+    }
+    return ::isOffTrack(contactPoints, hasContact, track);
+}
+
+bool isOffTrack(const glm::vec3* lastContactPoints, const bool* hasContact, const Track* track)
 {
     if (!track)
         return false;
 
-    const float TRACK_WIDTH = 12.0f; // Must match the TRACK_WIDTH in track.cpp
     const float halfWidth = TRACK_WIDTH / 2.0f;
 
     // Check if any wheel is on track
     for (int i = 0; i < 4; ++i)
     {
         // Only consider wheels that have made contact at some point
-        if (!wheels[i].hasContact && glm::length(wheels[i].lastContactPoint) < 0.01f)
+        if (!hasContact[i] && glm::length(lastContactPoints[i]) < 0.01f)
             continue; // Wheel hasn't touched ground yet (start of episode)
 
-        glm::vec3 contactPoint = wheels[i].lastContactPoint;
+        glm::vec3 contactPoint = lastContactPoints[i];
         glm::vec2 contactPoint2D(contactPoint.x, contactPoint.z);
 
         // Find closest point on track centerline
@@ -378,4 +208,64 @@ bool Vehicle::isOffTrack(Track* track) const
 
     // All wheels are off track (or no wheels have contacted ground)
     return true;
+}
+
+bool isCrashed(const glm::vec3& position, const glm::quat& orientation, const Track* track)
+{
+    // Check if underground (y < -2.0)
+    if (position.y < -2.0f)
+        return true;
+
+    // Check if too high in the air (y > 20.0)
+    if (position.y > 20.0f)
+        return true;
+
+    // Check if upside down - get the up vector in world space
+    glm::vec3 up = orientation * glm::vec3(0.0f, 1.0f, 0.0f);
+    // If the dot product with world up is negative, vehicle is upside down
+    if (up.y < -0.1f)
+        return true;
+
+    // Check if too far from track (horizontal distance > 100 units)
+    if (track)
+    {
+        glm::vec2 position2D = glm::vec2(position.x, position.z);
+        float t = track->getClosestT(position2D);
+        glm::vec2 trackPos = track->getPosition(t);
+        float distanceFromTrack = glm::distance(position2D, trackPos);
+        if (distanceFromTrack > 100.0f)
+            return true;
+    }
+
+    return false;
+}
+
+void Vehicle::resetTrackProgress(Track* track)
+{
+    if (!track)
+        return;
+
+    trackT = track->getClosestT(glm::vec2(body->position.x, body->position.z));
+    trackProgress = trackT;
+}
+
+void Vehicle::updateTrackProgress(Track* track)
+{
+    if (!track)
+        return;
+
+    // Warm-start from the previous substep's closest point
+    float newT = track->getClosestTNear(glm::vec2(body->position.x, body->position.z), trackT);
+
+    // A single substep covers a tiny fraction of a segment, so the shortest
+    // signed difference is always the true one
+    float numSegments = static_cast<float>(track->getNumSegments());
+    float delta = newT - trackT;
+    if (delta > numSegments / 2.0f)
+        delta -= numSegments;
+    else if (delta < -numSegments / 2.0f)
+        delta += numSegments;
+
+    trackT = newT;
+    trackProgress += delta;
 }
\ No newline at end of file
@@ -3,9 +3,11 @@
 #define VEHICLE_H
 
 #include <array>
+#include <memory>
 #include <glm/glm.hpp>
+#include "cache_line.h"
 #include "physics.h"
-#include "renderer.h"
+#include "telemetry.h"
 
 const glm::vec3 VEHICLE_DIMENSIONS(2.0f, 1.0f, 4.0f); // Width, Height, Length in meters
 const float VEHICLE_MASS = 1200.0f; // in kg
@@ -16,9 +18,6 @@ const float SUSPENSION_STIFFNESS = 70000.0f; // N/m
 const float SUSPENSION_DAMPING = 4500.0f; // Ns/m
 const float ANTI_ROLL_BAR_STIFFNESS = 5000.0f; // Nm/rad
 
-const int WHEEL_RENDER_RESOLUTION = 12; // Number of points around the wheel
-const float WHEEL_THICKNESS = 0.25f; // Thickness of the wheel in meters
-
 // Pacejka Magic Formula coefficients (simplified)
 struct PacejkaCoefficients
 {
@@ -28,6 +27,14 @@ struct PacejkaCoefficients
     float E; // Curvature factor
 };
 
+// Flat dynamic state used for snapshots and Jacobians:
+// position (3), orientation w, x, y, z (4), velocity (3), angular velocity (3),
+// suspension compression (4), wheel angular velocity (4), pending chassis force (3)
+// and torque (3). Wheels are FR, FL, RR, RL. The pending force is what the wheels applied
+// in the last substep; the world integrates it at the start of the next one.
+const int VEHICLE_STATE_SIZE = 27;
+const int VEHICLE_CONTROL_SIZE = 3; // steer, throttle, brake
+
 const PacejkaCoefficients PACEJKA_LONG = {10.0f, 1.9f, 1.0f, 0.97f};  // Longitudinal
 const PacejkaCoefficients PACEJKA_LAT = {8.0f, 1.3f, 1.0f, -1.6f};    // Lateral
 
@@ -44,43 +51,50 @@ struct Wheel
     float angularVelocity; // Current wheel angular velocity
     float rollAngle; // Current roll angle for rendering
     float steerAngle;
-    float driveTorque;
-    float brakeTorque;
     glm::vec3 lastContactPoint; // Last point where wheel touched ground
     bool hasContact; // Whether wheel is currently in contact
-float antiRollForce; // Force from anti-roll bar
-
-    // Calculate Pacejka Magic Formula
-    float calculatePacejka(float slip, const PacejkaCoefficients &coeff, float normalForce) const
-    {
-        float Fz = normalForce / 1000.0f; // Convert to kN for typical coefficients
-        float D = coeff.D * Fz;
-        float input = coeff.B * slip;
-        float output = D * glm::sin(coeff.C * glm::atan(input - coeff.E * (input - glm::atan(input))));
-        return output * 1000.0f; // Convert back to N
-    }
 };
 
-class Vehicle
+class ExpertDriver;
+
+class alignas(CACHE_LINE_SIZE) Vehicle
 {
 public:
     PhysicsWorld &world;
     PhysicsBody *body;
+    BoxShape *shape; // Body's shape, from the world's arena
+
+    float trackT;          // Closest track parameter, wrapped to [0, num_segments)
+    double trackProgress;  // Unwrapped distance along the track in segments
+
+    uint32_t telemetryId; // Stable per-context id stamped into telemetry records
+
+    std::unique_ptr<ExpertDriver> driver; // Scripted driver that sets the controls, or null
+    std::shared_ptr<const class MlpPolicy> policy; // Network that picks the controls each step, or null
 
     Vehicle(PhysicsWorld &world, const glm::vec3 &position, const glm::vec3 &rotation);
     ~Vehicle();
 
-    void step(float deltaTime);
-    void draw(int locModel, int locColor);
+    // Apply the wheel forces for one substep; fills record (except its substep) when given
+    void step(float deltaTime, TelemetryRecord* record = nullptr);
 
     void setSteerAmount(float steer); // -1.0 to 1.0
     void setThrottle(float throttle); // 0.0 to 1.0
     void setBrake(float brake);       // 0.0 to 1.0
+    float getSteerAmount() const { return steerAmount; }
+    float getThrottle() const { return throttle; }
+    float getBrake() const { return brake; }
+    float getWheelAngularVelocity(int wheel) const { return wheels[wheel].angularVelocity; }
+    const Wheel* getWheels() const { return wheels.data(); }
+
+    void getState(float* out) const; // VEHICLE_STATE_SIZE floats
+    void setState(const float* in);
     bool isOffTrack(class Track* track) const;
 
-private:
-    Mesh chassisMesh, wheelMesh;
+    void resetTrackProgress(class Track* track);
+    void updateTrackProgress(class Track* track);
 
+private:
     std::array<Wheel, 4> wheels;
 
     float steerAmount; // Current steering input
@@ -88,4 +102,10 @@ private:
     float brake;      // Current brake
 };
 
+// Off track when every wheel that has touched the ground last did so outside the track width
+bool isOffTrack(const glm::vec3* lastContactPoints, const bool* hasContact, const class Track* track);
+
+// Upside down, underground, too high, or too far from the track
+bool isCrashed(const glm::vec3& position, const glm::quat& orientation, const class Track* track);
+
 #endif // VEHICLE_H
\ No newline at end of file
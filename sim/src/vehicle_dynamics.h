@@ -0,0 +1,231 @@
+#ifndef VEHICLE_DYNAMICS_H
+
+#define VEHICLE_DYNAMICS_H
+
+#include "physics.h"
+#include "telemetry.h"
+#include "vehicle.h"
+
+// Vehicle dynamics templated on the scalar type. Vehicle::step runs the float
+// instantiation on the live physics body; instantiating with a dual number
+// (see dual.h) differentiates exactly the same code.
+
+template<typename T>
+struct VehicleDynamicsState
+{
+    BodyState<T> body;
+    T compression[4];
+    T wheelAngularVelocity[4];
+
+    // Flat layout is VEHICLE_STATE_SIZE values, see vehicle.h
+    template<typename S>
+    void load(const S *in)
+    {
+        body.position = Vec3<T>(in[0], in[1], in[2]);
+        body.orientation = Quat<T>(in[3], in[4], in[5], in[6]);
+        body.velocity = Vec3<T>(in[7], in[8], in[9]);
+        body.angularVelocity = Vec3<T>(in[10], in[11], in[12]);
+        for (int i = 0; i < 4; ++i)
+        {
+            compression[i] = in[13 + i];
+            wheelAngularVelocity[i] = in[17 + i];
+        }
+        body.force = Vec3<T>(in[21], in[22], in[23]);
+        body.torque = Vec3<T>(in[24], in[25], in[26]);
+    }
+
+    void store(T *out) const
+    {
+        const T values[VEHICLE_STATE_SIZE] = {
+            body.position.x, body.position.y, body.position.z,
+            body.orientation.w, body.orientation.x, body.orientation.y, body.orientation.z,
+            body.velocity.x, body.velocity.y, body.velocity.z,
+            body.angularVelocity.x, body.angularVelocity.y, body.angularVelocity.z,
+            compression[0], compression[1], compression[2], compression[3],
+            wheelAngularVelocity[0], wheelAngularVelocity[1], wheelAngularVelocity[2], wheelAngularVelocity[3],
+            body.force.x, body.force.y, body.force.z,
+            body.torque.x, body.torque.y, body.torque.z,
+        };
+        for (int i = 0; i < VEHICLE_STATE_SIZE; ++i)
+            out[i] = values[i];
+    }
+};
+
+// Where each wheel touched the ground this substep; bookkeeping only, never differentiated
+struct WheelContact
+{
+    bool hasContact;
+    glm::vec3 point;
+};
+
+// Pacejka Magic Formula
+template<typename T>
+T calculatePacejka(const T &slip, const PacejkaCoefficients &coeff, const T &normalForce)
+{
+    T Fz = normalForce / T(1000.0f); // Convert to kN for typical coefficients
+    T D = Fz * coeff.D;
+    T input = slip * coeff.B;
+    T output = D * scalar::sin(scalar::atan(input - (input - scalar::atan(input)) * coeff.E) * coeff.C);
+    return output * 1000.0f; // Convert back to N
+}
+
+// Accumulate suspension, tyre and drag forces on the body and advance the wheel spin.
+// wheels supplies the fixed wheel geometry. contacts and record are optional outputs.
+template<typename T>
+void applyVehicleForces(VehicleDynamicsState<T> &state, const Wheel *wheels,
+                        const T &steerAmount, const T &throttle, const T &brake, float deltaTime,
+                        WheelContact *contacts = nullptr, TelemetryRecord *record = nullptr)
+{
+    BodyState<T> &body = state.body;
+
+    T frontSteerAngle = steerAmount * glm::radians(30.0f);
+    T steerAngles[4] = {frontSteerAngle, frontSteerAngle, T(0.0f), T(0.0f)}; // Only the front wheels steer
+
+    T engineAngularVelocity = (state.wheelAngularVelocity[2] + state.wheelAngularVelocity[3]) / T(2.0f); // Simple average
+    T enginePower = throttle * 50000.0f; // Max 110kW
+    T engineTorque = scalar::min(enginePower / scalar::max(engineAngularVelocity, T(1.0f)), T(2000.0f)); // Limit max torque to 3000Nm
+    T driveTorque = engineTorque * 0.5f; // Split torque to rear wheels
+    T driveTorques[4] = {T(0.0f), T(0.0f), driveTorque, driveTorque};
+
+    T brakeTorque = brake * 3000.0f; // Max 2000Nm per wheel
+
+    T antiRollForces[4];
+    for(int i = 0; i < 2; i++)
+    {
+        int leftWheelIndex = i * 2 + 1;
+        int rightWheelIndex = i * 2 + 0;
+
+        T antiRollForce = (state.compression[leftWheelIndex] - state.compression[rightWheelIndex]) * ANTI_ROLL_BAR_STIFFNESS;
+
+        antiRollForces[leftWheelIndex] = -antiRollForce;
+        antiRollForces[rightWheelIndex] = antiRollForce;
+    }
+
+    // Suspension axis is local -Y
+    Vec3<T> suspAxisWorld = body.orientation * Vec3<T>(T(0.0f), T(-1.0f), T(0.0f));
+
+    for (int i = 0; i < 4; ++i)
+    {
+        if (contacts)
+            contacts[i].hasContact = false;
+
+        // Wheel mount position in world using quaternion rotation
+        Vec3<T> mountLocal(wheels[i].localPosition - glm::vec3(0.0f, wheels[i].wheelRadius, 0.0f));
+        Vec3<T> mountWorld = body.position + body.orientation * mountLocal;
+
+        float k = wheels[i].suspensionStiffness;
+
+        // Raycast to infinite plane y=0 along suspAxisWorld
+        // Solve mountWorld + suspAxisWorld * t => y = 0
+        T denom = suspAxisWorld.y;
+        if (scalar::abs(denom) < 1e-4f)
+            continue; // axis parallel to ground, skip
+        T t = -mountWorld.y / denom;
+
+        if (t < 0.0f)
+            continue; // pointing away from ground
+
+        // Limit to suspension reach
+        if (t > wheels[i].restLength)
+            continue; // no contact within suspension
+
+        Vec3<T> contactPoint = mountWorld + suspAxisWorld * t;
+        if (contacts)
+        {
+            contacts[i].hasContact = true;
+            contacts[i].point = contactPoint.toGlm();
+        }
+
+        // Compression is how much shorter than rest the ray is
+        T compression = T(wheels[i].restLength) - t;
+        T compressionVelocity = (compression - state.compression[i]) / T(deltaTime);
+        T forceMag = compression * k + compressionVelocity * SUSPENSION_DAMPING + antiRollForces[i];
+
+        state.compression[i] = compression;
+
+        // Ground normal for y=0 plane
+        Vec3<T> suspensionForce(T(0.0f), forceMag, T(0.0f));
+
+        // Calculate tire forces using Pacejka Magic Formula
+        // Get wheel world orientation (including steer angle)
+        Quat<T> wheelOrientation = body.orientation * angleAxisY(steerAngles[i]);
+
+        // Forward and side directions in world space
+        Vec3<T> forwardDir = wheelOrientation * Vec3<T>(T(0.0f), T(0.0f), T(1.0f));
+        Vec3<T> sideDir = wheelOrientation * Vec3<T>(T(1.0f), T(0.0f), T(0.0f));
+
+        // Velocity at contact point
+        Vec3<T> r = contactPoint - body.position;
+        Vec3<T> contactVelocity = body.velocity + cross(body.angularVelocity, r);
+
+        // Project velocity onto forward and side directions
+        T forwardSpeed = dot(contactVelocity, forwardDir);
+        T sideSpeed = dot(contactVelocity, sideDir);
+        T slipSpeed = scalar::max(scalar::abs(forwardSpeed), T(0.1f));
+        // Calculate slip ratio (longitudinal slip)
+        T wheelCircumSpeed = state.wheelAngularVelocity[i] * wheels[i].wheelRadius;
+        T slipRatio = (wheelCircumSpeed - forwardSpeed) / slipSpeed;
+        // Calculate slip angle (lateral slip)
+        T slipAngle = scalar::atan(-sideSpeed / slipSpeed);
+
+        // Apply Pacejka Magic Formula
+        T normalForce = forceMag;
+        T longitudinalForce = calculatePacejka(slipRatio, PACEJKA_LONG, normalForce);
+        T lateralForce = calculatePacejka(slipAngle, PACEJKA_LAT, normalForce);
+
+        if (record)
+        {
+            record->slipRatio[i] = scalar::value(slipRatio);
+            record->slipAngle[i] = scalar::value(slipAngle);
+            record->normalForce[i] = scalar::value(normalForce);
+            record->longitudinalForce[i] = scalar::value(longitudinalForce);
+            record->lateralForce[i] = scalar::value(lateralForce);
+        }
+
+        // Combine forces in world space
+        Vec3<T> tireForce = suspensionForce + forwardDir * longitudinalForce + sideDir * lateralForce;
+
+        // Apply at contact point to induce correct torque
+        body.force += tireForce;
+        body.torque += cross(r, tireForce);
+
+        // Update wheel angular velocity
+        // Torque on wheel = driveTorque - longitudinalForce * wheelRadius
+        T wheelTorque = driveTorques[i] - longitudinalForce * wheels[i].wheelRadius;
+        T angularAcceleration = wheelTorque / T(wheels[i].inertia);
+        T &angularVelocity = state.wheelAngularVelocity[i];
+        angularVelocity += angularAcceleration * deltaTime;
+
+        // Apply braking
+        T brakeDelta = brakeTorque / T(wheels[i].inertia) * deltaTime;
+        if (scalar::abs(angularVelocity) > brakeDelta)
+        {
+            if (angularVelocity > 0.0f)
+                angularVelocity -= brakeDelta;
+            else
+                angularVelocity += brakeDelta;
+        }
+        else
+        {
+            angularVelocity = T(0.0f);
+        }
+    }
+
+    body.force += -body.velocity * length(body.velocity) * T(0.4f); // Simple drag
+}
+
+// One full physics substep for a vehicle alone in a world: integrate the pending
+// forces plus gravity, then apply the vehicle's forces at the new state. Matches
+// PhysicsWorld::stepSimulation followed by Vehicle::step.
+template<typename T>
+void stepVehicleDynamics(VehicleDynamicsState<T> &state, const Vehicle &vehicle,
+                         const T &steerAmount, const T &throttle, const T &brake, float deltaTime,
+                         WheelContact *contacts = nullptr)
+{
+    const PhysicsBody &body = *vehicle.body;
+    state.body.force += Vec3<T>(vehicle.world.gravity * body.mass);
+    integrateBody(state.body, body.mass, body.inertia, deltaTime);
+    applyVehicleForces(state, vehicle.getWheels(), steerAmount, throttle, brake, deltaTime, contacts);
+}
+
+#endif // VEHICLE_DYNAMICS_H
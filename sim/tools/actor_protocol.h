@@ -0,0 +1,76 @@
+#ifndef ACTOR_PROTOCOL_H
+#define ACTOR_PROTOCOL_H
+
+#include <cstdint>
+#include "../src/sim.h"
+
+// Wire format between racegym_actor and its learners (racegym/actor_client.py), over TCP.
+// Every message is an ActorHeader followed by payloadBytes of payload, all little-endian.
+// Requests on a connection are handled strictly in order and each gets exactly one response
+// echoing its requestId, so a client may keep several requests in flight (e.g. one step per
+// batch) and match responses by order. Several batches can live on one connection.
+//
+// Payloads:
+//   CREATE  request  ActorCreateRequest                 response ActorCreateResponse
+//   RESET   request  uint64 seed                         response float obs[n][obsSize]
+//   STEP    request  float actions[n][actionSize]        response see below
+//   STATS   request  none (flags may hold ACTOR_FLAG_RESET_STATS)   response SimEpisodeStats (sim.h)
+//   CLOSE   request  none                                response none
+//
+// A STEP response holds, in order: float obs[n][obsSize] (already reset for finished
+// episodes), float reward[n], float lapTime[n] (NaN unless a lap was completed),
+// uint8 terminated[n], uint8 truncated[n], then float terminalObs[d][obsSize] for the
+// d envs that finished this step, in env order.
+
+// Doubles as the protocol version: change it whenever a layout here or in sim.h changes,
+// so mismatched clients are dropped instead of misreading payloads
+const uint32_t ACTOR_MAGIC = 0x32434752; // "RGC2"; SimEpisodeStats with the faulted count
+const uint32_t ACTOR_MAX_PAYLOAD = 64u << 20;
+// Largest STEP response per env (every env finished), which bounds the batch size
+const uint32_t ACTOR_STEP_BYTES_PER_ENV = 2 * SIM_OBSERVATION_SIZE * sizeof(float) + 2 * sizeof(float) + 2;
+const uint32_t ACTOR_MAX_ENVS = ACTOR_MAX_PAYLOAD / ACTOR_STEP_BYTES_PER_ENV;
+
+enum ActorOp : uint16_t {
+    ACTOR_OP_CREATE = 1, // Create a batch of environments; the response header carries its id
+    ACTOR_OP_RESET = 2,
+    ACTOR_OP_STEP = 3,
+    ACTOR_OP_STATS = 4,
+    ACTOR_OP_CLOSE = 5,  // Free a batch
+};
+
+const uint16_t ACTOR_FLAG_RESET_STATS = 1 << 0;
+
+enum ActorStatus : int16_t {
+    ACTOR_OK = 0,
+    ACTOR_ERROR_PROTOCOL = 1,  // Unknown op, bad payload size or unknown batch
+    ACTOR_ERROR_RESOURCES = 2, // The batch could not be created, or exceeds ACTOR_MAX_ENVS
+};
+
+struct ActorHeader {
+    uint32_t magic;
+    uint16_t op;
+    uint16_t flags;  // Request: ACTOR_FLAG_*; response: ActorStatus
+    uint32_t requestId;
+    uint32_t batchId;
+    uint32_t payloadBytes;
+};
+
+struct ActorCreateRequest {
+    uint32_t numEnvs;
+    int32_t fixedStart;
+    int32_t maxEpisodeSteps;
+};
+
+struct ActorCreateResponse {
+    uint32_t numEnvs;
+    uint32_t observationSize;
+    uint32_t actionSize;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(ActorHeader) == 20, "ActorHeader layout is shared with external clients");
+static_assert(sizeof(ActorCreateRequest) == 12, "ActorCreateRequest layout is shared with external clients");
+static_assert(sizeof(ActorCreateResponse) == 16, "ActorCreateResponse layout is shared with external clients");
+static_assert(sizeof(SimEpisodeStats) == 1224, "SimEpisodeStats layout is shared with external clients");
+
+#endif // ACTOR_PROTOCOL_H
@@ -0,0 +1,357 @@
+// racegym_actor: remote actor for distributed rollouts. Serves batches of native
+// environments over TCP (see actor_protocol.h) to learners on other nodes, which drive
+// them with racegym/actor_client.py. Each connection is served by its own thread;
+// requests queue up in the socket, so clients pipeline by sending ahead. Connections
+// share the process-wide thread pool for stepping.
+//
+// Usage:
+//   racegym_actor --tracks <dir> [--port N] [--bind <address>] [--pin-threads]
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "../src/sim.h"
+#include "actor_protocol.h"
+
+namespace {
+
+volatile std::sig_atomic_t stopRequested = 0;
+
+void onSignal(int) {
+    stopRequested = 1;
+}
+
+bool readFully(int fd, void* data, size_t size) {
+    char* bytes = static_cast<char*>(data);
+    while (size > 0) {
+        ssize_t n = recv(fd, bytes, size, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        bytes += n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+bool writeFully(int fd, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t n = send(fd, bytes, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        bytes += n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+// One batch of environments with the arrays its VecEnv reads and writes
+struct Batch {
+    void* vecEnv = nullptr;
+    int numEnvs = 0;
+    std::vector<float> actions;
+    std::vector<float> observations;
+    std::vector<float> rewards;
+    std::vector<float> lapTimes;
+    std::vector<float> terminalObservations;
+    std::vector<unsigned char> terminated;
+    std::vector<unsigned char> truncated;
+
+    // Leaves vecEnv null if the batch could not be allocated; an exception escaping a
+    // connection thread would take down every other connection with it
+    Batch(void* trackSet, const ActorCreateRequest& request) {
+        numEnvs = (int)request.numEnvs;
+        try {
+            vecEnv = sim_vec_env_create(trackSet, numEnvs, request.fixedStart, request.maxEpisodeSteps);
+            if (!vecEnv) {
+                return;
+            }
+            size_t n = numEnvs;
+            actions.assign(n * SIM_ACTION_SIZE, 0.0f);
+            observations.assign(n * SIM_OBSERVATION_SIZE, 0.0f);
+            rewards.assign(n, 0.0f);
+            lapTimes.assign(n, 0.0f);
+            terminalObservations.assign(n * SIM_OBSERVATION_SIZE, 0.0f);
+            terminated.assign(n, 0);
+            truncated.assign(n, 0);
+        } catch (const std::exception& e) {
+            std::cerr << "Cannot create a batch of " << numEnvs << " environments: " << e.what() << std::endl;
+            sim_vec_env_free(vecEnv);
+            vecEnv = nullptr;
+            return;
+        }
+        sim_vec_env_set_buffers(vecEnv, actions.data(), observations.data(), rewards.data(), terminated.data(),
+                                truncated.data(), lapTimes.data(), terminalObservations.data());
+    }
+
+    ~Batch() {
+        sim_vec_env_free(vecEnv);
+    }
+};
+
+template <typename T>
+void append(std::vector<char>& out, const T* data, size_t count) {
+    const char* bytes = reinterpret_cast<const char*>(data);
+    out.insert(out.end(), bytes, bytes + sizeof(T) * count);
+}
+
+class Connection {
+public:
+    // The socket stays open after serve() returns; the owner closes it
+    Connection(int fd, void* trackSet) : fd(fd), trackSet(trackSet) {}
+
+    void serve() {
+        ActorHeader header;
+        std::vector<char> request;
+        std::vector<char> response;
+        while (!stopRequested && readFully(fd, &header, sizeof(header))) {
+            if (header.magic != ACTOR_MAGIC || header.payloadBytes > ACTOR_MAX_PAYLOAD) {
+                std::cerr << "Dropping connection after a malformed request" << std::endl;
+                return;
+            }
+            request.resize(header.payloadBytes);
+            if (!readFully(fd, request.data(), request.size())) {
+                return;
+            }
+
+            response.clear();
+            ActorStatus status = handle(header, request, response);
+
+            ActorHeader reply = header;
+            reply.flags = (uint16_t)status;
+            reply.payloadBytes = status == ACTOR_OK ? (uint32_t)response.size() : 0;
+            if (status != ACTOR_OK) {
+                response.clear();
+            }
+            response.insert(response.begin(), reinterpret_cast<const char*>(&reply),
+                            reinterpret_cast<const char*>(&reply) + sizeof(reply));
+            if (!writeFully(fd, response.data(), response.size())) {
+                return;
+            }
+        }
+    }
+
+private:
+    ActorStatus handle(ActorHeader& header, const std::vector<char>& request, std::vector<char>& response) {
+        if (header.op == ACTOR_OP_CREATE) {
+            ActorCreateRequest create;
+            if (request.size() != sizeof(create)) {
+                return ACTOR_ERROR_PROTOCOL;
+            }
+            std::memcpy(&create, request.data(), sizeof(create));
+            if (create.numEnvs == 0 || create.maxEpisodeSteps <= 0) {
+                return ACTOR_ERROR_PROTOCOL;
+            }
+            if (create.numEnvs > ACTOR_MAX_ENVS) {
+                return ACTOR_ERROR_RESOURCES;
+            }
+            std::unique_ptr<Batch> batch(new (std::nothrow) Batch(trackSet, create));
+            if (!batch) {
+                return ACTOR_ERROR_RESOURCES;
+            }
+            if (!batch->vecEnv) {
+                return ACTOR_ERROR_RESOURCES;
+            }
+            header.batchId = nextBatchId++;
+            batches[header.batchId] = std::move(batch);
+
+            ActorCreateResponse created = {create.numEnvs, SIM_OBSERVATION_SIZE, SIM_ACTION_SIZE, 0};
+            append(response, &created, 1);
+            return ACTOR_OK;
+        }
+
+        auto it = batches.find(header.batchId);
+        if (it == batches.end()) {
+            return ACTOR_ERROR_PROTOCOL;
+        }
+        Batch& batch = *it->second;
+        const size_t n = batch.numEnvs;
+
+        switch (header.op) {
+            case ACTOR_OP_RESET: {
+                uint64_t seed;
+                if (request.size() != sizeof(seed)) {
+                    return ACTOR_ERROR_PROTOCOL;
+                }
+                std::memcpy(&seed, request.data(), sizeof(seed));
+                sim_vec_env_reset(batch.vecEnv, seed);
+                append(response, batch.observations.data(), batch.observations.size());
+                return ACTOR_OK;
+            }
+            case ACTOR_OP_STEP: {
+                if (request.size() != batch.actions.size() * sizeof(float)) {
+                    return ACTOR_ERROR_PROTOCOL;
+                }
+                std::memcpy(batch.actions.data(), request.data(), request.size());
+                sim_vec_env_step_batch(&batch.vecEnv, 1);
+
+                append(response, batch.observations.data(), batch.observations.size());
+                append(response, batch.rewards.data(), n);
+                append(response, batch.lapTimes.data(), n);
+                append(response, batch.terminated.data(), n);
+                append(response, batch.truncated.data(), n);
+                for (size_t i = 0; i < n; i++) {
+                    if (batch.terminated[i] || batch.truncated[i]) {
+                        append(response, &batch.terminalObservations[i * SIM_OBSERVATION_SIZE], SIM_OBSERVATION_SIZE);
+                    }
+                }
+                return ACTOR_OK;
+            }
+            case ACTOR_OP_STATS: {
+                SimEpisodeStats stats;
+                sim_vec_env_get_stats(batch.vecEnv, &stats, header.flags & ACTOR_FLAG_RESET_STATS);
+                append(response, &stats, 1);
+                return ACTOR_OK;
+            }
+            case ACTOR_OP_CLOSE:
+                batches.erase(it);
+                return ACTOR_OK;
+            default:
+                return ACTOR_ERROR_PROTOCOL;
+        }
+    }
+
+    int fd;
+    void* trackSet;
+    uint32_t nextBatchId = 1;
+    std::map<uint32_t, std::unique_ptr<Batch>> batches;
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string tracksDir;
+    std::string bindAddress = "0.0.0.0";
+    int port = 7717;
+    bool pinThreads = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--tracks" && i + 1 < argc) {
+            tracksDir = argv[++i];
+        } else if (arg == "--port" && i + 1 < argc) {
+            port = std::atoi(argv[++i]);
+        } else if (arg == "--bind" && i + 1 < argc) {
+            bindAddress = argv[++i];
+        } else if (arg == "--pin-threads") {
+            pinThreads = true;
+        } else {
+            tracksDir.clear();
+            break;
+        }
+    }
+    if (tracksDir.empty()) {
+        std::cerr << "Usage: racegym_actor --tracks <dir> [--port N] [--bind <address>] [--pin-threads]\n"
+                  << "  --tracks       Directory of *.json / *.rgt tracks served to every batch\n"
+                  << "  --port         TCP port to listen on (default 7717)\n"
+                  << "  --bind         Address to listen on (default 0.0.0.0; 127.0.0.1 for loopback only)\n"
+                  << "  --pin-threads  Pin each stepping thread to its own CPU\n";
+        return 2;
+    }
+    if (pinThreads && sim_pin_worker_threads() != 0) {
+        std::cerr << "Could not pin worker threads; continuing unpinned" << std::endl;
+    }
+
+    void* trackSet = sim_load_track_set(tracksDir.c_str());
+    if (!trackSet) {
+        return 1;
+    }
+
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    if (inet_pton(AF_INET, bindAddress.c_str(), &addr.sin_addr) != 1) {
+        std::cerr << "Invalid bind address: " << bindAddress << std::endl;
+        return 2;
+    }
+
+    int listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    int reuse = 1;
+    if (listenFd < 0 || setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) != 0 ||
+        bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listenFd, 64) != 0) {
+        std::perror("racegym_actor");
+        return 1;
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    std::cerr << "racegym_actor serving " << tracksDir << " on " << bindAddress << ":" << port << std::endl;
+
+    struct Worker {
+        int fd;
+        std::atomic<bool> finished{false};
+        std::thread thread;
+    };
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    auto reap = [&workers](bool all) {
+        for (auto it = workers.begin(); it != workers.end();) {
+            Worker& worker = **it;
+            if (!all && !worker.finished) {
+                ++it;
+                continue;
+            }
+            // Wakes a connection blocked waiting for its next request
+            shutdown(worker.fd, SHUT_RDWR);
+            worker.thread.join();
+            close(worker.fd);
+            it = workers.erase(it);
+        }
+    };
+
+    // Poll so a signal stops the accept loop
+    while (!stopRequested) {
+        reap(false);
+        pollfd pfd = {listenFd, POLLIN, 0};
+        if (poll(&pfd, 1, 500) <= 0) {
+            continue;
+        }
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            continue;
+        }
+        int noDelay = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+        std::unique_ptr<Worker> worker(new Worker());
+        worker->fd = fd;
+        Worker* w = worker.get();
+        worker->thread = std::thread([w, trackSet]() {
+            Connection connection(w->fd, trackSet);
+            connection.serve();
+            w->finished = true;
+        });
+        workers.push_back(std::move(worker));
+    }
+
+    close(listenFd);
+    reap(true);
+    sim_free_track_set(trackSet);
+    return 0;
+}
@@ -0,0 +1,329 @@
+// racegym_eval: headless lap-time evaluation of a native policy or the built-in
+// expert driver over a track set. Every (track, start) pair is one episode in its
+// own context; all episodes step together through sim_step_batch. Results are
+// written as JSON, for nightly regression of agent quality without Python.
+//
+// Usage:
+//   racegym_eval --tracks <dir> [--policy <file.rgmp> | --expert]
+//                [--starts N] [--laps N] [--max-steps N] [--output <file>]
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "../src/sim.h"
+
+namespace {
+
+struct Options {
+    std::string tracksDir;
+    std::string policyPath;
+    std::string outputPath;
+    int starts = 4;
+    int laps = 2;
+    int maxSteps = 3000;
+};
+
+enum class Outcome { Running, Completed, OffTrack, Crashed, TimedOut };
+
+struct Episode {
+    void* ctx = nullptr;
+    void* vehicle = nullptr;
+    int trackIndex = 0;
+    float spawnT = 0.0f;
+    float trackLength = 0.0f;
+    float startProgress = 0.0f;
+    float lastProgress = 0.0f;
+    int steps = 0;
+    Outcome outcome = Outcome::Running;
+    std::vector<float> lapTimes; // Seconds per lap; the first starts from standstill
+};
+
+struct Summary {
+    std::vector<float> firstLaps;
+    std::vector<float> flyingLaps;
+    double progressLaps = 0.0;
+    int episodes = 0;
+    int completed = 0;
+    int offTrack = 0;
+    int crashed = 0;
+    int timedOut = 0;
+
+    void add(const Episode& e) {
+        episodes++;
+        progressLaps += (e.lastProgress - e.startProgress) / e.trackLength;
+        switch (e.outcome) {
+            case Outcome::Completed: completed++; break;
+            case Outcome::OffTrack: offTrack++; break;
+            case Outcome::Crashed: crashed++; break;
+            default: timedOut++; break;
+        }
+        for (size_t i = 0; i < e.lapTimes.size(); i++) {
+            (i == 0 ? firstLaps : flyingLaps).push_back(e.lapTimes[i]);
+        }
+    }
+};
+
+void printUsage() {
+    std::cerr << "Usage: racegym_eval --tracks <dir> [--policy <file.rgmp> | --expert]\n"
+              << "                    [--starts N] [--laps N] [--max-steps N] [--output <file>]\n"
+              << "  --tracks     Directory of *.json / *.rgt tracks\n"
+              << "  --policy     Policy exported with racegym/policy_export.py\n"
+              << "  --expert     Drive with the built-in expert driver (default)\n"
+              << "  --starts     Evenly spaced start positions per track (default 4)\n"
+              << "  --laps       Laps an episode must complete (default 2)\n"
+              << "  --max-steps  Step limit per episode, 0.1 s each (default 3000)\n"
+              << "  --output     Write JSON here instead of stdout\n";
+}
+
+bool parseOptions(int argc, char** argv, Options& opts) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--tracks" && hasValue) {
+            opts.tracksDir = argv[++i];
+        } else if (arg == "--policy" && hasValue) {
+            opts.policyPath = argv[++i];
+        } else if (arg == "--expert") {
+            opts.policyPath.clear();
+        } else if (arg == "--starts" && hasValue) {
+            opts.starts = std::atoi(argv[++i]);
+        } else if (arg == "--laps" && hasValue) {
+            opts.laps = std::atoi(argv[++i]);
+        } else if (arg == "--max-steps" && hasValue) {
+            opts.maxSteps = std::atoi(argv[++i]);
+        } else if (arg == "--output" && hasValue) {
+            opts.outputPath = argv[++i];
+        } else {
+            std::cerr << "Unknown or incomplete argument: " << arg << std::endl;
+            return false;
+        }
+    }
+
+    if (opts.tracksDir.empty() || opts.starts <= 0 || opts.laps <= 0 || opts.maxSteps <= 0) {
+        return false;
+    }
+    return true;
+}
+
+// Advance an episode's bookkeeping after one step and decide whether it is over
+void updateEpisode(Episode& e, int maxLaps, int maxSteps) {
+    float progress = sim_get_vehicle_progress(e.vehicle);
+    float delta = progress - e.lastProgress;
+
+    // Interpolate the moment the start line was crossed within the step, as the env does
+    float lapTarget = e.startProgress + e.trackLength * (e.lapTimes.size() + 1);
+    if (delta > 0.0f && progress >= lapTarget) {
+        float crossTime = (e.steps + (lapTarget - e.lastProgress) / delta) * SIM_STEP_SECONDS;
+        float previous = 0.0f;
+        for (float lap : e.lapTimes) {
+            previous += lap;
+        }
+        e.lapTimes.push_back(crossTime - previous);
+    }
+
+    e.lastProgress = progress;
+    e.steps++;
+
+    if ((int)e.lapTimes.size() >= maxLaps) {
+        e.outcome = Outcome::Completed;
+    } else if (sim_is_vehicle_crashed(e.ctx, e.vehicle)) {
+        e.outcome = Outcome::Crashed;
+    } else if (sim_is_vehicle_off_track(e.ctx, e.vehicle)) {
+        e.outcome = Outcome::OffTrack;
+    } else if (e.steps >= maxSteps) {
+        e.outcome = Outcome::TimedOut;
+    }
+}
+
+void writeLapStats(std::ostream& out, const char* key, std::vector<float> laps) {
+    out << "\"" << key << "\": ";
+    if (laps.empty()) {
+        out << "null";
+        return;
+    }
+
+    std::sort(laps.begin(), laps.end());
+    double sum = 0.0;
+    for (float lap : laps) {
+        sum += lap;
+    }
+    double mean = sum / laps.size();
+    double var = 0.0;
+    for (float lap : laps) {
+        var += (lap - mean) * (lap - mean);
+    }
+
+    out << "{\"count\": " << laps.size()
+        << ", \"mean\": " << mean
+        << ", \"std\": " << std::sqrt(var / laps.size())
+        << ", \"min\": " << laps.front()
+        << ", \"median\": " << laps[laps.size() / 2]
+        << ", \"max\": " << laps.back() << "}";
+}
+
+void writeSummary(std::ostream& out, const Summary& s, const char* indent) {
+    out << indent << "\"episodes\": " << s.episodes << ",\n"
+        << indent << "\"completed\": " << s.completed << ",\n"
+        << indent << "\"completion_rate\": " << (s.episodes ? (double)s.completed / s.episodes : 0.0) << ",\n"
+        << indent << "\"off_track\": " << s.offTrack << ",\n"
+        << indent << "\"crashed\": " << s.crashed << ",\n"
+        << indent << "\"timed_out\": " << s.timedOut << ",\n"
+        << indent << "\"mean_progress_laps\": " << (s.episodes ? s.progressLaps / s.episodes : 0.0) << ",\n"
+        << indent;
+    writeLapStats(out, "first_lap", s.firstLaps);
+    out << ",\n" << indent;
+    writeLapStats(out, "flying_lap", s.flyingLaps);
+    out << "\n";
+}
+
+void writeEscaped(std::ostream& out, const std::string& text) {
+    out << '"';
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out << '\\' << c;
+        } else if ((unsigned char)c < 0x20) {
+            out << ' ';
+        } else {
+            out << c;
+        }
+    }
+    out << '"';
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opts;
+    if (!parseOptions(argc, argv, opts)) {
+        printUsage();
+        return 2;
+    }
+
+    void* trackSet = sim_load_track_set(opts.tracksDir.c_str());
+    if (!trackSet) {
+        return 1;
+    }
+
+    void* policy = nullptr;
+    if (!opts.policyPath.empty()) {
+        policy = sim_load_policy(opts.policyPath.c_str());
+        if (!policy) {
+            std::cerr << "Failed to load policy: " << opts.policyPath << std::endl;
+            sim_free_track_set(trackSet);
+            return 1;
+        }
+    }
+
+    int numTracks = sim_get_track_set_size(trackSet);
+    std::vector<Episode> episodes;
+    episodes.reserve((size_t)numTracks * opts.starts);
+    for (int t = 0; t < numTracks; t++) {
+        for (int s = 0; s < opts.starts; s++) {
+            Episode e;
+            e.ctx = sim_init(0);
+            e.trackIndex = t;
+            if (!e.ctx || sim_select_track(e.ctx, trackSet, t) != 0) {
+                std::cerr << "Failed to set up track " << sim_get_track_set_name(trackSet, t) << std::endl;
+                return 1;
+            }
+
+            e.trackLength = (float)sim_get_track_length(e.ctx);
+            e.spawnT = e.trackLength * s / opts.starts;
+            e.vehicle = sim_add_vehicle(e.ctx, e.spawnT);
+            if (!e.vehicle) {
+                std::cerr << "Failed to add vehicle on track " << sim_get_track_set_name(trackSet, t) << std::endl;
+                return 1;
+            }
+            if (policy) {
+                if (sim_attach_policy(e.vehicle, policy) != 0) {
+                    return 1;
+                }
+            } else {
+                sim_attach_expert_driver(e.vehicle, nullptr);
+            }
+
+            e.startProgress = sim_get_vehicle_progress(e.vehicle);
+            e.lastProgress = e.startProgress;
+            episodes.push_back(e);
+        }
+    }
+
+    // Step every unfinished episode together; finished ones drop out of the batch
+    auto wallStart = std::chrono::steady_clock::now();
+    std::vector<Episode*> active;
+    for (Episode& e : episodes) {
+        active.push_back(&e);
+    }
+    std::vector<void*> contexts;
+    long long totalSteps = 0;
+    while (!active.empty()) {
+        contexts.clear();
+        for (Episode* e : active) {
+            contexts.push_back(e->ctx);
+        }
+        sim_step_batch(contexts.data(), (int)contexts.size());
+        totalSteps += (long long)contexts.size();
+
+        for (Episode* e : active) {
+            updateEpisode(*e, opts.laps, opts.maxSteps);
+        }
+        active.erase(std::remove_if(active.begin(), active.end(),
+                                    [](const Episode* e) { return e->outcome != Outcome::Running; }),
+                     active.end());
+    }
+    std::chrono::duration<double> wallSeconds = std::chrono::steady_clock::now() - wallStart;
+
+    std::vector<Summary> perTrack(numTracks);
+    Summary overall;
+    for (const Episode& e : episodes) {
+        perTrack[e.trackIndex].add(e);
+        overall.add(e);
+    }
+
+    std::ofstream file;
+    if (!opts.outputPath.empty()) {
+        file.open(opts.outputPath);
+        if (!file) {
+            std::cerr << "Failed to open output: " << opts.outputPath << std::endl;
+            return 1;
+        }
+    }
+    std::ostream& out = opts.outputPath.empty() ? std::cout : file;
+
+    out << "{\n  \"controller\": " << (policy ? "\"policy\"" : "\"expert\"") << ",\n";
+    if (policy) {
+        out << "  \"policy\": ";
+        writeEscaped(out, opts.policyPath);
+        out << ",\n";
+    }
+    out << "  \"starts_per_track\": " << opts.starts << ",\n"
+        << "  \"laps\": " << opts.laps << ",\n"
+        << "  \"max_steps\": " << opts.maxSteps << ",\n"
+        << "  \"step_seconds\": " << SIM_STEP_SECONDS << ",\n"
+        << "  \"wall_seconds\": " << wallSeconds.count() << ",\n"
+        << "  \"steps_per_second\": " << (wallSeconds.count() > 0.0 ? totalSteps / wallSeconds.count() : 0.0) << ",\n"
+        << "  \"tracks\": [\n";
+    for (int t = 0; t < numTracks; t++) {
+        out << "    {\n      \"name\": ";
+        writeEscaped(out, sim_get_track_set_name(trackSet, t));
+        out << ",\n";
+        writeSummary(out, perTrack[t], "      ");
+        out << "    }" << (t + 1 < numTracks ? "," : "") << "\n";
+    }
+    out << "  ],\n  \"overall\": {\n";
+    writeSummary(out, overall, "    ");
+    out << "  }\n}\n";
+
+    for (Episode& e : episodes) {
+        sim_shutdown(e.ctx);
+    }
+    sim_free_policy(policy);
+    sim_free_track_set(trackSet);
+    return 0;
+}
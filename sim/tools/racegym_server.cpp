@@ -0,0 +1,426 @@
+// racegym_server: one process hosting the environments of several trainers on a node.
+// Clients connect over a Unix domain socket (see server_protocol.h) and exchange
+// actions and results through per-client shared memory. Step requests arriving from
+// different clients within a short window are stepped together in one parallel pass,
+// so all trainers share the server's thread pool instead of each running its own workers.
+//
+// Usage:
+//   racegym_server [--socket <path>] [--batch-window-us N] [--pin-threads]
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "../src/shared_memory.h"
+#include "../src/sim.h"
+#include "server_protocol.h"
+
+namespace {
+
+volatile std::sig_atomic_t stopRequested = 0;
+
+void onSignal(int) {
+    stopRequested = 1;
+}
+
+struct Client {
+    int fd = -1;
+    uint32_t id = 0;
+    void* vecEnv = nullptr;
+    SharedMemoryRegion shm;
+    bool stepPending = false;
+    size_t statsOffset = 0;
+    ServerRequest request;      // Being received; the socket is read without blocking
+    size_t requestBytes = 0;
+
+    ~Client() {
+        sim_vec_env_free(vecEnv);
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+};
+
+bool writeFully(int fd, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+        ssize_t n = send(fd, bytes, size, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return false;
+        }
+        bytes += n;
+        size -= (size_t)n;
+    }
+    return true;
+}
+
+bool reply(Client& client, int32_t status) {
+    ServerResponse response;
+    std::memset(&response, 0, sizeof(response));
+    response.status = status;
+    return writeFully(client.fd, &response, sizeof(response));
+}
+
+size_t alignUp(size_t value) {
+    return (value + 63) & ~(size_t)63; // Keep every array on its own cache lines
+}
+
+class Server {
+public:
+    explicit Server(std::chrono::microseconds batchWindow) : batchWindow(batchWindow) {}
+
+    ~Server() {
+        clients.clear();
+        for (auto& set : trackSets) {
+            sim_free_track_set(set.second);
+        }
+        if (listenFd >= 0) {
+            close(listenFd);
+            unlink(socketPath.c_str());
+        }
+    }
+
+    bool listenOn(const std::string& path) {
+        sockaddr_un addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(addr.sun_path)) {
+            std::cerr << "Socket path too long: " << path << std::endl;
+            return false;
+        }
+        std::memcpy(addr.sun_path, path.c_str(), path.size());
+
+        listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listenFd < 0) {
+            std::perror("socket");
+            return false;
+        }
+        unlink(path.c_str()); // Remove a socket left behind by a previous server
+        if (bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(listenFd, 64) != 0) {
+            std::perror(path.c_str());
+            return false;
+        }
+        socketPath = path;
+        return true;
+    }
+
+    void run() {
+        std::vector<pollfd> fds;
+        while (!stopRequested) {
+            fds.clear();
+            fds.push_back({listenFd, POLLIN, 0});
+            for (auto& client : clients) {
+                fds.push_back({client->fd, POLLIN, 0});
+            }
+
+            // Wait indefinitely when idle (waking up to notice signals); once a step is
+            // pending, only until the batch window closes
+            int timeoutMs = 500;
+            if (anyStepPending()) {
+                auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    batchDeadline - std::chrono::steady_clock::now());
+                timeoutMs = std::max(0, (int)remaining.count());
+            }
+
+            int ready = poll(fds.data(), fds.size(), timeoutMs);
+            if (ready < 0 && errno != EINTR) {
+                std::perror("poll");
+                break;
+            }
+
+            if (ready > 0) {
+                // Client slots are looked up by fd since handling may drop clients
+                for (size_t i = 1; i < fds.size(); i++) {
+                    if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) {
+                        handleClient(fds[i].fd);
+                    }
+                }
+                if (fds[0].revents & POLLIN) {
+                    acceptClient();
+                }
+            }
+
+            if (anyStepPending() && (allActiveStepPending() || std::chrono::steady_clock::now() >= batchDeadline)) {
+                stepPending();
+            }
+        }
+    }
+
+private:
+    void acceptClient() {
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            return;
+        }
+        std::unique_ptr<Client> client(new Client());
+        client->fd = fd;
+        client->id = nextClientId++;
+        clients.push_back(std::move(client));
+    }
+
+    void dropClient(int fd) {
+        clients.erase(std::remove_if(clients.begin(), clients.end(),
+                                     [fd](const std::unique_ptr<Client>& c) { return c->fd == fd; }),
+                      clients.end());
+    }
+
+    void handleClient(int fd) {
+        auto it = std::find_if(clients.begin(), clients.end(),
+                               [fd](const std::unique_ptr<Client>& c) { return c->fd == fd; });
+        if (it == clients.end()) {
+            return;
+        }
+        Client& client = **it;
+
+        // Take whatever has arrived and wait for the rest on a later poll, so a client
+        // that sends part of a request can't stall everyone else sharing the server
+        char* buffer = reinterpret_cast<char*>(&client.request);
+        ssize_t n = recv(fd, buffer + client.requestBytes, sizeof(client.request) - client.requestBytes, MSG_DONTWAIT);
+        if (n < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return;
+        }
+        if (n <= 0) {
+            dropClient(fd);
+            return;
+        }
+        client.requestBytes += (size_t)n;
+        if (client.requestBytes < sizeof(client.request)) {
+            return;
+        }
+        client.requestBytes = 0;
+        const ServerRequest request = client.request;
+        if (request.magic != SERVER_MAGIC || request.version != SERVER_PROTOCOL_VERSION) {
+            reply(client, SERVER_ERROR_PROTOCOL);
+            dropClient(fd);
+            return;
+        }
+
+        bool ok = true;
+        switch (request.op) {
+            case SERVER_OP_HELLO:
+                ok = hello(client, request);
+                break;
+            case SERVER_OP_RESET:
+                if (!client.vecEnv || client.stepPending) {
+                    ok = reply(client, SERVER_ERROR_PROTOCOL);
+                    break;
+                }
+                sim_vec_env_reset(client.vecEnv, request.seed);
+                ok = reply(client, SERVER_OK);
+                break;
+            case SERVER_OP_STEP:
+                if (!client.vecEnv || client.stepPending) {
+                    ok = reply(client, SERVER_ERROR_PROTOCOL);
+                    break;
+                }
+                if (!anyStepPending()) {
+                    batchDeadline = std::chrono::steady_clock::now() + batchWindow;
+                }
+                client.stepPending = true;
+                break;
+            case SERVER_OP_STATS:
+                if (!client.vecEnv || client.stepPending) {
+                    ok = reply(client, SERVER_ERROR_PROTOCOL);
+                    break;
+                }
+                sim_vec_env_get_stats(client.vecEnv, statsBuffer(client),
+                                      (request.flags & SERVER_FLAG_RESET_STATS) != 0);
+                ok = reply(client, SERVER_OK);
+                break;
+            case SERVER_OP_CLOSE:
+            default:
+                ok = false;
+                break;
+        }
+
+        if (!ok) {
+            dropClient(fd);
+        }
+    }
+
+    bool hello(Client& client, const ServerRequest& request) {
+        if (client.vecEnv || request.numEnvs == 0) {
+            return reply(client, SERVER_ERROR_PROTOCOL);
+        }
+        if (request.numEnvs > SERVER_MAX_ENVS) {
+            return reply(client, SERVER_ERROR_RESOURCES);
+        }
+
+        std::string trackDir(request.trackSet, strnlen(request.trackSet, sizeof(request.trackSet)));
+        void* trackSet = getTrackSet(trackDir);
+        if (!trackSet) {
+            return reply(client, SERVER_ERROR_TRACKS);
+        }
+
+        const size_t n = request.numEnvs;
+        ServerResponse response;
+        std::memset(&response, 0, sizeof(response));
+        size_t sizes[SERVER_BUFFER_COUNT];
+        sizes[SERVER_BUFFER_ACTIONS] = n * SIM_ACTION_SIZE * sizeof(float);
+        sizes[SERVER_BUFFER_OBSERVATIONS] = n * SIM_OBSERVATION_SIZE * sizeof(float);
+        sizes[SERVER_BUFFER_REWARDS] = n * sizeof(float);
+        sizes[SERVER_BUFFER_LAP_TIMES] = n * sizeof(float);
+        sizes[SERVER_BUFFER_TERMINAL_OBSERVATIONS] = n * SIM_OBSERVATION_SIZE * sizeof(float);
+        sizes[SERVER_BUFFER_TERMINATED] = n;
+        sizes[SERVER_BUFFER_TRUNCATED] = n;
+        sizes[SERVER_BUFFER_STATS] = sizeof(SimEpisodeStats);
+        size_t offset = 0;
+        for (int i = 0; i < SERVER_BUFFER_COUNT; i++) {
+            response.offsets[i] = offset;
+            offset = alignUp(offset + sizes[i]);
+        }
+
+        std::snprintf(response.shmName, sizeof(response.shmName), "racegym_server_%d_%u", (int)getpid(), client.id);
+        // Only a client with buffers in place may keep its VecEnv: later requests are
+        // guarded by vecEnv alone
+        void* vecEnv = nullptr;
+        try {
+            vecEnv = sim_vec_env_create(trackSet, (int)n, request.fixedStart, request.maxEpisodeSteps);
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+        }
+        if (!vecEnv || !client.shm.create(response.shmName, offset)) {
+            std::cerr << "Failed to create " << n << " environments for client " << client.id << std::endl;
+            sim_vec_env_free(vecEnv);
+            return reply(client, SERVER_ERROR_RESOURCES);
+        }
+        client.vecEnv = vecEnv;
+
+        char* base = static_cast<char*>(client.shm.getData());
+        auto floats = [&](int buffer) { return reinterpret_cast<float*>(base + response.offsets[buffer]); };
+        auto bytes = [&](int buffer) { return reinterpret_cast<unsigned char*>(base + response.offsets[buffer]); };
+        sim_vec_env_set_buffers(client.vecEnv, floats(SERVER_BUFFER_ACTIONS), floats(SERVER_BUFFER_OBSERVATIONS),
+                                floats(SERVER_BUFFER_REWARDS), bytes(SERVER_BUFFER_TERMINATED),
+                                bytes(SERVER_BUFFER_TRUNCATED), floats(SERVER_BUFFER_LAP_TIMES),
+                                floats(SERVER_BUFFER_TERMINAL_OBSERVATIONS));
+
+        response.status = SERVER_OK;
+        response.numEnvs = request.numEnvs;
+        response.observationSize = SIM_OBSERVATION_SIZE;
+        response.actionSize = SIM_ACTION_SIZE;
+        response.shmSize = offset;
+        client.statsOffset = response.offsets[SERVER_BUFFER_STATS];
+        std::cerr << "Client " << client.id << ": " << n << " environments on " << trackDir << std::endl;
+        return writeFully(client.fd, &response, sizeof(response));
+    }
+
+    static SimEpisodeStats* statsBuffer(Client& client) {
+        return reinterpret_cast<SimEpisodeStats*>(static_cast<char*>(client.shm.getData()) + client.statsOffset);
+    }
+
+    void* getTrackSet(const std::string& directory) {
+        auto it = trackSets.find(directory);
+        if (it != trackSets.end()) {
+            return it->second;
+        }
+        void* set = sim_load_track_set(directory.c_str());
+        if (set) {
+            trackSets[directory] = set;
+        }
+        return set;
+    }
+
+    bool anyStepPending() const {
+        for (auto& client : clients) {
+            if (client->stepPending) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool allActiveStepPending() const {
+        for (auto& client : clients) {
+            if (client->vecEnv && !client->stepPending) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    void stepPending() {
+        std::vector<void*> batch;
+        for (auto& client : clients) {
+            if (client->stepPending) {
+                batch.push_back(client->vecEnv);
+            }
+        }
+        sim_vec_env_step_batch(batch.data(), (int)batch.size());
+
+        std::vector<int> failed;
+        for (auto& client : clients) {
+            if (client->stepPending) {
+                client->stepPending = false;
+                if (!reply(*client, SERVER_OK)) {
+                    failed.push_back(client->fd);
+                }
+            }
+        }
+        for (int fd : failed) {
+            dropClient(fd);
+        }
+    }
+
+    std::chrono::microseconds batchWindow;
+    std::chrono::steady_clock::time_point batchDeadline;
+    int listenFd = -1;
+    std::string socketPath;
+    uint32_t nextClientId = 0;
+    std::vector<std::unique_ptr<Client>> clients;
+    std::map<std::string, void*> trackSets; // Loaded once, shared by every client using them
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::string socketPath = "/tmp/racegym.sock";
+    long batchWindowUs = 2000;
+    bool pinThreads = false;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--socket" && i + 1 < argc) {
+            socketPath = argv[++i];
+        } else if (arg == "--batch-window-us" && i + 1 < argc) {
+            batchWindowUs = std::atol(argv[++i]);
+        } else if (arg == "--pin-threads") {
+            pinThreads = true;
+        } else {
+            std::cerr << "Usage: racegym_server [--socket <path>] [--batch-window-us N] [--pin-threads]\n"
+                      << "  --socket           Unix socket to listen on (default /tmp/racegym.sock)\n"
+                      << "  --batch-window-us  How long a step request waits for other clients' steps\n"
+                      << "                     before the batch runs (default 2000)\n"
+                      << "  --pin-threads      Pin each stepping thread to its own CPU\n";
+            return 2;
+        }
+    }
+    if (pinThreads && sim_pin_worker_threads() != 0) {
+        std::cerr << "Could not pin worker threads; continuing unpinned" << std::endl;
+    }
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+
+    Server server{std::chrono::microseconds(batchWindowUs)};
+    if (!server.listenOn(socketPath)) {
+        return 1;
+    }
+    std::cerr << "racegym_server listening on " << socketPath << std::endl;
+    server.run();
+    return 0;
+}
@@ -0,0 +1,72 @@
+#ifndef SERVER_PROTOCOL_H
+#define SERVER_PROTOCOL_H
+
+#include <cstdint>
+
+// Wire format between racegym_server and its clients (racegym/server_client.py).
+// Every message is a fixed-size little-endian struct; clients send a ServerRequest
+// and receive one ServerResponse for each, in order. Bulk data never goes over the
+// socket: HELLO returns the name of a shared memory region holding the action and
+// result arrays of the client's environments, laid out at the returned offsets.
+
+const uint32_t SERVER_MAGIC = 0x56534752; // "RGSV"
+const uint32_t SERVER_PROTOCOL_VERSION = 3;
+
+const uint32_t SERVER_FLAG_RESET_STATS = 1 << 0;
+const uint32_t SERVER_MAX_ENVS = 1 << 16; // Per client
+
+enum ServerOp : uint32_t {
+    SERVER_OP_HELLO = 1, // Create the client's environments and their shared memory
+    SERVER_OP_RESET = 2, // Start new episodes in every environment (uses seed)
+    SERVER_OP_STEP = 3,  // Step with the actions in shared memory; batched with other clients
+    SERVER_OP_CLOSE = 4, // Release the environments; the server closes the connection
+    SERVER_OP_STATS = 5, // Write the episode statistics to shared memory (flags may reset them)
+};
+
+enum ServerStatus : int32_t {
+    SERVER_OK = 0,
+    SERVER_ERROR_PROTOCOL = 1,  // Bad magic or version, or an op out of order
+    SERVER_ERROR_TRACKS = 2,    // The track set could not be loaded
+    SERVER_ERROR_RESOURCES = 3, // Environments or shared memory could not be created, or too many requested
+};
+
+struct ServerRequest {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t op;
+    uint32_t numEnvs;        // HELLO
+    int32_t fixedStart;      // HELLO
+    int32_t maxEpisodeSteps; // HELLO
+    uint64_t seed;           // RESET
+    uint32_t flags;          // STATS: SERVER_FLAG_*
+    uint32_t reserved;
+    char trackSet[256];      // HELLO: track directory, as seen by the server
+};
+
+// Arrays in the shared memory region, in order of ServerResponse::offsets
+enum ServerBuffer {
+    SERVER_BUFFER_ACTIONS,               // float [numEnvs][actionSize], written by the client
+    SERVER_BUFFER_OBSERVATIONS,          // float [numEnvs][observationSize]
+    SERVER_BUFFER_REWARDS,               // float [numEnvs]
+    SERVER_BUFFER_LAP_TIMES,             // float [numEnvs], NaN unless a lap was completed
+    SERVER_BUFFER_TERMINAL_OBSERVATIONS, // float [numEnvs][observationSize]
+    SERVER_BUFFER_TERMINATED,            // uint8 [numEnvs]
+    SERVER_BUFFER_TRUNCATED,             // uint8 [numEnvs]
+    SERVER_BUFFER_STATS,                 // SimEpisodeStats, written on STATS
+    SERVER_BUFFER_COUNT
+};
+
+struct ServerResponse {
+    int32_t status;
+    uint32_t numEnvs;
+    uint32_t observationSize;
+    uint32_t actionSize;
+    uint64_t shmSize;
+    uint64_t offsets[SERVER_BUFFER_COUNT];
+    char shmName[64];
+};
+
+static_assert(sizeof(ServerRequest) == 296, "ServerRequest layout is shared with external clients");
+static_assert(sizeof(ServerResponse) == 152, "ServerResponse layout is shared with external clients");
+
+#endif // SERVER_PROTOCOL_H
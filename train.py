@@ -1,23 +1,29 @@
+from pathlib import Path
+
 import gymnasium as gym
 import numpy as np
 from stable_baselines3 import PPO
-from stable_baselines3.common.vec_env import SubprocVecEnv, DummyVecEnv, VecNormalize
+from stable_baselines3.common.vec_env import DummyVecEnv, VecNormalize
 from stable_baselines3.common.monitor import Monitor
 from stable_baselines3.common.callbacks import CheckpointCallback, CallbackList
 
 from racegym.env import RaceGymEnv
+from racegym.zygote import make_zygote_vec_env
 from eval_callback import RaceGymEvalCallback
 
+# Tracks to train and evaluate on; the zygote preloads the same set for its workers
+TRACK_SET = str(Path(__file__).resolve().parent / "tracks")
+
 def make_env(render_mode=None, fixed_start=False):
     def _init():
-        env = RaceGymEnv(render_mode=render_mode, fixed_start=fixed_start)
+        env = RaceGymEnv(render_mode=render_mode, fixed_start=fixed_start, track_set=TRACK_SET)
         env = Monitor(env)
         return env
     return _init
 
 if __name__ == "__main__":
     # VecEnv wrapper (training envs) with observation/reward normalization
-    vec_env = SubprocVecEnv([make_env(render_mode=None) for _ in range(4)])
+    vec_env = make_zygote_vec_env([make_env(render_mode=None) for _ in range(4)], track_sets=[TRACK_SET])
     vec_env = VecNormalize(vec_env, norm_obs=True, norm_reward=True, clip_obs=10.0)
     
     # Create evaluation environment (single env) sharing normalization stats